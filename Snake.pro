@@ -4,13 +4,70 @@ CONFIG -= app_bundle
 CONFIG -= qt
 
 SOURCES += \
-        main.cpp
+        main.cpp \
+        process.cpp \
+        botpipe.cpp \
+        bots.cpp \
+        tournament.cpp \
+        trainer.cpp \
+        mlp.cpp \
+        distfield.cpp \
+        dstar.cpp \
+        safety.cpp \
+        renderer.cpp \
+        ansirenderer.cpp \
+        recorder.cpp \
+        rasterizer.cpp \
+        mappedfile.cpp \
+        levelpack.cpp \
+        levelgen.cpp \
+        levelwatch.cpp \
+        ticker.cpp \
+        scores.cpp \
+        apples.cpp \
+        spawn.cpp \
+        rewind.cpp \
+        lockstep.cpp \
+        events.cpp \
+        metrics.cpp \
+        trace.cpp \
+        board.cpp
 
 unix: CONFIG += link_pkgconfig
 unix: PKGCONFIG += ncurses
+unix: LIBS += -pthread
 
 HEADERS += \
-    snake.h
+    snake.h \
+    process.h \
+    botpipe.h \
+    args.h \
+    bots.h \
+    tournament.h \
+    trainer.h \
+    mlp.h \
+    distfield.h \
+    dstar.h \
+    safety.h \
+    renderer.h \
+    ansirenderer.h \
+    recorder.h \
+    rasterizer.h \
+    mappedfile.h \
+    levelpack.h \
+    levelgen.h \
+    levelwatch.h \
+    ticker.h \
+    scores.h \
+    apples.h \
+    spawn.h \
+    rewind.h \
+    lockstep.h \
+    events.h \
+    metrics.h \
+    trace.h \
+    board.h \
+    bitboard.h
 
 DISTFILES += \
     level2.txt
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <cstring>
+#include "ansirenderer.h"
+#include "metrics.h"
+
+#ifdef _WIN32
+#include <conio.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static struct termios savedTermios;
+#endif
+
+// Worst case per cell: cursor move, colour switch and the glyph
+const size_t ANSI_MAX_CELL_BYTES = 32;
+
+// Colours of field chars, anything else uses the default style
+enum AnsiStyle {
+    STYLE_DEFAULT,
+    STYLE_WALL,
+    STYLE_SNAKE,
+    STYLE_APPLE,
+};
+
+static const char* const STYLE_SGR[] = {
+    "\x1b[0m",
+    "\x1b[0;2m",
+    "\x1b[0;32m",
+    "\x1b[0;1;31m",
+};
+
+static int styleOf(char ch)
+{
+    switch (ch)
+    {
+    case '#': return STYLE_WALL;
+    case '*': return STYLE_SNAKE;
+    case '@': return STYLE_APPLE;
+    default: return STYLE_DEFAULT;
+    }
+}
+
+static int numberLength(int value)
+{
+    return value < 10 ? 1 : (value < 100 ? 2 : 3);
+}
+
+AnsiRenderer::AnsiRenderer() : screen(ANSI_SCREEN_WIDTH * ANSI_SCREEN_HEIGHT, ' '),
+                               shown(ANSI_SCREEN_WIDTH * ANSI_SCREEN_HEIGHT, 0),
+                               frame(ANSI_SCREEN_WIDTH * ANSI_SCREEN_HEIGHT * ANSI_MAX_CELL_BYTES),
+                               frameSize(0), cursorX(-1), cursorY(-1), style(-1),
+                               inputTimeout(-1), active(false), written(0)
+{
+}
+
+bool AnsiRenderer::init()
+{
+#ifdef _WIN32
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (!GetConsoleMode(out, &mode) || !SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+        return false;
+#else
+    if (tcgetattr(STDIN_FILENO, &savedTermios) != 0)
+        return false;
+
+    struct termios raw = savedTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+#endif
+
+    active = true;
+
+    // Alternate screen, hidden cursor, blank screen
+    const char start[] = "\x1b[?1049h\x1b[?25l\x1b[0m\x1b[2J";
+    std::fill(shown.begin(), shown.end(), ' ');
+    cursorX = cursorY = style = -1;
+    return writeOut(start, sizeof(start) - 1);
+}
+
+void AnsiRenderer::shutdown()
+{
+    if (!active)
+        return;
+
+    const char stop[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+    writeOut(stop, sizeof(stop) - 1);
+
+#ifndef _WIN32
+    tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+#endif
+    active = false;
+}
+
+void AnsiRenderer::clearScreen()
+{
+    std::fill(screen.begin(), screen.end(), ' ');
+}
+
+void AnsiRenderer::drawString(int x, int y, const char* str)
+{
+    for (; *str; ++str, ++x)
+        drawChar(x, y, *str);
+}
+
+void AnsiRenderer::drawChar(int x, int y, char ch)
+{
+    if (x >= 0 && y >= 0 && x < ANSI_SCREEN_WIDTH && y < ANSI_SCREEN_HEIGHT)
+        screen[y * ANSI_SCREEN_WIDTH + x] = ch;
+}
+
+void AnsiRenderer::put(const char* str, size_t size)
+{
+    std::memcpy(&frame[frameSize], str, size);
+    frameSize += size;
+}
+
+void AnsiRenderer::putNumber(int value)
+{
+    char digits[4];
+    int length = numberLength(value);
+    for (int i = length - 1; i >= 0; --i, value /= 10)
+        digits[i] = static_cast<char>('0' + value % 10);
+    put(digits, length);
+}
+
+void AnsiRenderer::setStyle(int newStyle)
+{
+    if (style == newStyle)
+        return;
+    put(STYLE_SGR[newStyle], std::strlen(STYLE_SGR[newStyle]));
+    style = newStyle;
+}
+
+void AnsiRenderer::moveCursor(int x, int y)
+{
+    if (x == cursorX && y == cursorY)
+        return;
+
+    // Absolute move always works: ESC [ row ; col H
+    int bestCost = 4 + numberLength(y + 1) + numberLength(x + 1);
+    enum { ABSOLUTE, REWRITE, VERTICAL, FORWARD, BACKWARD, RETURN_FORWARD } best = ABSOLUTE;
+    int verticalCost = 0;
+
+    if (cursorX >= 0)
+    {
+        int dy = y - cursorY;
+        verticalCost = dy == 0 ? 0 : 3 + numberLength(dy > 0 ? dy : -dy);
+        int dx = x - cursorX;
+
+        // Going right over unchanged cells of the current style is cheapest when close
+        bool canRewrite = dy == 0 && dx > 0;
+        for (int i = cursorX; canRewrite && i < x; ++i)
+        {
+            int cell = y * ANSI_SCREEN_WIDTH + i;
+            canRewrite = shown[cell] != 0 && shown[cell] == screen[cell] && styleOf(shown[cell]) == style;
+        }
+
+        if (canRewrite && dx < bestCost)
+        {
+            best = REWRITE;
+            bestCost = dx;
+        }
+        if (dx == 0 && verticalCost < bestCost)
+        {
+            best = VERTICAL;
+            bestCost = verticalCost;
+        }
+        if (dx > 0 && verticalCost + 3 + numberLength(dx) < bestCost)
+        {
+            best = FORWARD;
+            bestCost = verticalCost + 3 + numberLength(dx);
+        }
+        if (dx < 0 && verticalCost + 3 + numberLength(-dx) < bestCost)
+        {
+            best = BACKWARD;
+            bestCost = verticalCost + 3 + numberLength(-dx);
+        }
+        int returnCost = verticalCost + 1 + (x == 0 ? 0 : 3 + numberLength(x));
+        if (dx < 0 && returnCost < bestCost)
+        {
+            best = RETURN_FORWARD;
+            bestCost = returnCost;
+        }
+    }
+
+    if (best == ABSOLUTE)
+    {
+        put("\x1b[", 2);
+        putNumber(y + 1);
+        put(";", 1);
+        putNumber(x + 1);
+        put("H", 1);
+    }
+    else if (best == REWRITE)
+    {
+        put(&screen[y * ANSI_SCREEN_WIDTH + cursorX], x - cursorX);
+    }
+    else
+    {
+        int dy = y - cursorY;
+        if (dy != 0)
+        {
+            put("\x1b[", 2);
+            putNumber(dy > 0 ? dy : -dy);
+            put(dy > 0 ? "B" : "A", 1);
+        }
+
+        int fromX = cursorX;
+        if (best == RETURN_FORWARD)
+        {
+            put("\r", 1);
+            fromX = 0;
+        }
+
+        int dx = x - fromX;
+        if (dx != 0)
+        {
+            put("\x1b[", 2);
+            putNumber(dx > 0 ? dx : -dx);
+            put(dx > 0 ? "C" : "D", 1);
+        }
+    }
+
+    cursorX = x;
+    cursorY = y;
+}
+
+void AnsiRenderer::refreshScreen()
+{
+    frameSize = 0;
+
+    for (int y = 0; y < ANSI_SCREEN_HEIGHT; ++y)
+    {
+        for (int x = 0; x < ANSI_SCREEN_WIDTH; ++x)
+        {
+            int cell = y * ANSI_SCREEN_WIDTH + x;
+            char ch = screen[cell];
+            if (shown[cell] == ch)
+                continue;
+
+            moveCursor(x, y);
+            setStyle(styleOf(ch));
+            put(&ch, 1);
+            shown[cell] = ch;
+
+            // Terminal keeps the cursor on the last column instead of wrapping
+            cursorX = x + 1 < ANSI_SCREEN_WIDTH ? x + 1 : -1;
+        }
+    }
+
+    if (frameSize > 0)
+        writeOut(frame.data(), frameSize);
+}
+
+#ifdef _WIN32
+
+bool AnsiRenderer::writeOut(const char* data, size_t size)
+{
+    DWORD done = 0;
+    bool ok = WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, static_cast<DWORD>(size), &done, nullptr) && done == size;
+    written += done;
+    countMetric(Metric::TERMINAL_BYTES, done);
+    return ok;
+}
+
+int AnsiRenderer::readByte(int ms)
+{
+    for (int waited = 0; !_kbhit(); waited += 10)
+    {
+        if (ms >= 0 && waited >= ms)
+            return -1;
+        Sleep(10);
+    }
+    return _getch();
+}
+
+int AnsiRenderer::readInput()
+{
+    int ch = readByte(inputTimeout);
+    if (ch != 0 && ch != 224)
+        return ch < 0 ? INPUT_NONE : ch;
+
+    switch (readByte(-1))
+    {
+    case 72: return INPUT_UP;
+    case 80: return INPUT_DOWN;
+    case 75: return INPUT_LEFT;
+    case 77: return INPUT_RIGHT;
+    default: return INPUT_NONE;
+    }
+}
+
+#else
+
+bool AnsiRenderer::writeOut(const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t done = write(STDOUT_FILENO, data, size);
+        if (done < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        written += done;
+        countMetric(Metric::TERMINAL_BYTES, static_cast<uint64_t>(done));
+        data += done;
+        size -= static_cast<size_t>(done);
+    }
+    return true;
+}
+
+int AnsiRenderer::readByte(int ms)
+{
+    struct pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    if (poll(&fd, 1, ms) <= 0)
+        return -1;
+
+    unsigned char ch;
+    return read(STDIN_FILENO, &ch, 1) == 1 ? ch : -1;
+}
+
+int AnsiRenderer::readInput()
+{
+    int ch = readByte(inputTimeout);
+    if (ch != 0x1b)
+        return ch < 0 ? INPUT_NONE : ch;
+
+    // Arrow keys come as ESC [ A..D
+    if (readByte(50) != '[')
+        return INPUT_NONE;
+
+    switch (readByte(50))
+    {
+    case 'A': return INPUT_UP;
+    case 'B': return INPUT_DOWN;
+    case 'C': return INPUT_RIGHT;
+    case 'D': return INPUT_LEFT;
+    default: return INPUT_NONE;
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "renderer.h"
+
+/**
+* Renderer writing ANSI escape sequences without curses.
+*
+* Draw calls go to a back buffer. refreshScreen() compares it with what
+* the terminal already shows and composes only the changed cells,
+* with the cheapest cursor moves and colour switches, into one
+* preallocated buffer that is flushed with a single write().
+*/
+const int ANSI_SCREEN_WIDTH = 80;
+const int ANSI_SCREEN_HEIGHT = 24;
+
+class AnsiRenderer : public Renderer {
+public:
+    AnsiRenderer();
+
+    bool init() override;
+    void shutdown() override;
+
+    void clearScreen() override;
+    void drawString(int x, int y, const char* str) override;
+    void drawChar(int x, int y, char ch) override;
+    void refreshScreen() override;
+
+    int readInput() override;
+    void setInputTimeout(int ms) override { inputTimeout = ms; }
+
+    unsigned long long bytesWritten() const { return written; }
+
+private:
+    bool writeOut(const char* data, size_t size);
+    int readByte(int ms);
+
+    void moveCursor(int x, int y);
+    void setStyle(int style);
+    void put(const char* str, size_t size);
+    void putNumber(int value);
+
+    std::vector<char> screen;       // Back buffer, ANSI_SCREEN_HEIGHT rows of ANSI_SCREEN_WIDTH chars
+    std::vector<char> shown;        // What the terminal shows, 0 - unknown
+
+    std::vector<char> frame;        // Preallocated for the worst case frame
+    size_t frameSize;
+
+    int cursorX;                    // -1 - unknown
+    int cursorY;
+    int style;                      // Current SGR style, -1 - unknown
+
+    int inputTimeout;
+    bool active;
+    unsigned long long written;
+};
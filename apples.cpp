@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cstdlib>
+#include "apples.h"
+
+AppleIndex::AppleIndex() : width(0), height(0), bucketsX(0), bucketsY(0), count(0)
+{
+}
+
+void AppleIndex::reset(int w, int h)
+{
+    width = w;
+    height = h;
+    bucketsX = (w + APPLE_BUCKET - 1) / APPLE_BUCKET;
+    bucketsY = (h + APPLE_BUCKET - 1) / APPLE_BUCKET;
+    count = 0;
+
+    // Keep the bucket storage around, games restart a lot in tournaments
+    buckets.resize(bucketsX * bucketsY);
+    for (auto &bucket : buckets)
+        bucket.clear();
+    slot.assign(w * h, -1);
+}
+
+void AppleIndex::insert(const Point &p)
+{
+    int &cell = slot[p.y * width + p.x];
+    if (cell >= 0)
+        return;
+
+    std::vector<Point> &bucket = buckets[bucketOf(p)];
+    cell = static_cast<int>(bucket.size());
+    bucket.push_back(p);
+    count++;
+}
+
+bool AppleIndex::erase(const Point &p)
+{
+    int &cell = slot[p.y * width + p.x];
+    if (cell < 0)
+        return false;
+
+    std::vector<Point> &bucket = buckets[bucketOf(p)];
+    const Point last = bucket.back();
+    bucket[cell] = last;
+    slot[last.y * width + last.x] = cell;
+    bucket.pop_back();
+    cell = -1;
+    count--;
+    return true;
+}
+
+bool AppleIndex::nearest(const Point &from, Point &apple) const
+{
+    if (count == 0)
+        return false;
+
+    const int fx = static_cast<int>(from.x), fy = static_cast<int>(from.y);
+    const int bx = fx / APPLE_BUCKET, by = fy / APPLE_BUCKET;
+    const int maxRing = std::max(std::max(bx, bucketsX - 1 - bx), std::max(by, bucketsY - 1 - by));
+
+    int best = -1;
+    for (int ring = 0; ring <= maxRing; ++ring)
+    {
+        // Every cell in this ring is at least (ring - 1) * APPLE_BUCKET + 1 away
+        if (best >= 0 && best <= (ring - 1) * APPLE_BUCKET)
+            break;
+
+        for (int y = by - ring; y <= by + ring; ++y)
+        {
+            if (y < 0 || y >= bucketsY)
+                continue;
+
+            // Only the outline of the ring, the inside was searched already
+            int step = y == by - ring || y == by + ring ? 1 : 2 * ring;
+            for (int x = bx - ring; x <= bx + ring; x += std::max(step, 1))
+            {
+                if (x < 0 || x >= bucketsX)
+                    continue;
+
+                for (const Point &p : buckets[y * bucketsX + x])
+                {
+                    int distance = std::abs(static_cast<int>(p.x) - fx) + std::abs(static_cast<int>(p.y) - fy);
+                    // Ties go to the first apple in row order, whatever order the buckets are in
+                    if (best < 0 || distance < best
+                        || (distance == best && (p.y < apple.y || (p.y == apple.y && p.x < apple.x))))
+                    {
+                        best = distance;
+                        apple = p;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
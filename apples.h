@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include "snake.h"
+
+/**
+* Apples on the field, bucketed into a coarse grid of APPLE_BUCKET x APPLE_BUCKET cells.
+*
+* insert/erase/contains are O(1): every cell remembers its slot in its bucket
+* and erase swaps the last apple of the bucket into the hole.
+* nearest() searches rings of buckets around the start and stops as soon as
+* no bucket further out can hold anything closer, so it only looks at
+* buckets near the answer no matter how many apples there are.
+*/
+const int APPLE_BUCKET = 4;
+
+class AppleIndex {
+public:
+    AppleIndex();
+
+    void reset(int width, int height);
+
+    void insert(const Point &p);
+    bool erase(const Point &p);
+    bool contains(const Point &p) const { return slot[p.y * width + p.x] >= 0; }
+    size_t size() const { return count; }
+
+    // Closest apple by Manhattan distance, false if there are none
+    bool nearest(const Point &from, Point &apple) const;
+
+private:
+    int bucketOf(const Point &p) const { return static_cast<int>(p.y) / APPLE_BUCKET * bucketsX + static_cast<int>(p.x) / APPLE_BUCKET; }
+
+    int width;
+    int height;
+    int bucketsX;
+    int bucketsY;
+    size_t count;
+    std::vector<std::vector<Point>> buckets;
+    std::vector<int> slot;      // Per cell, index in its bucket or -1
+};
+
+extern thread_local AppleIndex apples;
+extern thread_local unsigned int appleTarget;  // Apples kept on the field, --apples
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+/**
+* Minimal command line parser.
+* Options look like "--name value" or just "--name" for flags.
+*/
+class Args {
+public:
+    Args(int argc, char* argv[]) : argc(argc), argv(argv) {}
+
+    bool has(const char* name) const { return find(name) != 0; }
+    const char* program() const { return argv[0]; }
+
+    const char* value(const char* name, const char* def = nullptr) const
+    {
+        int i = find(name);
+        if (i == 0 || i + 1 >= argc)
+            return def;
+        return argv[i + 1];
+    }
+
+    long intValue(const char* name, long def) const
+    {
+        const char* str = value(name);
+        return str ? strtol(str, nullptr, 10) : def;
+    }
+
+    double doubleValue(const char* name, double def) const
+    {
+        const char* str = value(name);
+        return str ? strtod(str, nullptr) : def;
+    }
+
+private:
+    int find(const char* name) const
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp(argv[i], name) == 0)
+                return i;
+        }
+        return 0;
+    }
+
+    int argc;
+    char** argv;
+};
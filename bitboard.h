@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "snake.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+* Board sizes and bitboards over them.
+*
+* A bitboard keeps one bit per cell, row by row, each row in as many 64 bit
+* words as its width needs: one word up to 64 columns, more above that.
+* A cell is numbered by its bit, y * pitch() + x, so arrays indexed by cell
+* number and bitboards agree, and the cells next to a cell are +-1 and +-pitch().
+*
+* Testing a cell is one AND. spread() moves every bit of a board to its four
+* neighbours at once, a word at a time, so flood fills and breadth first
+* searches take one pass over the words per step instead of one per cell.
+*
+* FixedBoardSize makes all of that compile time constants, DynamicBoardSize
+* takes the size at run time.
+*/
+template <int W, int H>
+struct FixedBoardSize {
+    template <typename T> using Cells = std::array<T, H * ((W + 63) / 64 * 64)>;
+    template <typename T> using Words = std::array<T, H * ((W + 63) / 64)>;
+
+    static constexpr int width() { return W; }
+    static constexpr int height() { return H; }
+    static constexpr int rowWords() { return (W + 63) / 64; }
+    static constexpr int pitch() { return (W + 63) / 64 * 64; }
+    static constexpr int cells() { return H * pitch(); }
+    static constexpr int words() { return H * rowWords(); }
+    static constexpr bool isFixed() { return true; }
+
+    template <typename T, size_t N>
+    void allocate(std::array<T, N> &, int) const {}
+};
+
+struct DynamicBoardSize {
+    template <typename T> using Cells = std::vector<T>;
+    template <typename T> using Words = std::vector<T>;
+
+    DynamicBoardSize(int width, int height) : w(width), h(height) {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int rowWords() const { return (w + 63) / 64; }
+    int pitch() const { return rowWords() * 64; }
+    int cells() const { return h * pitch(); }
+    int words() const { return h * rowWords(); }
+    static constexpr bool isFixed() { return false; }
+
+    template <typename T>
+    void allocate(std::vector<T> &v, int count) const { v.resize(static_cast<size_t>(count)); }
+
+    int w;
+    int h;
+};
+
+inline int bitCount(uint64_t word)
+{
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+inline int lowestBit(uint64_t word)    // Word must not be 0
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+template <typename Size>
+class Bitboard {
+public:
+    explicit Bitboard(const Size &boardSize = Size()) : size(boardSize)
+    {
+        size.allocate(bits, size.words());
+        clear();
+    }
+
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    bool test(int cell) const { return (bits[cell >> 6] >> (cell & 63)) & 1; }
+    void set(int cell) { bits[cell >> 6] |= 1ULL << (cell & 63); }
+    void reset(int cell) { bits[cell >> 6] &= ~(1ULL << (cell & 63)); }
+
+    uint64_t word(int i) const { return bits[i]; }
+
+    int count() const
+    {
+        int total = 0;
+        for (uint64_t word : bits)
+            total += bitCount(word);
+        return total;
+    }
+
+    bool any() const
+    {
+        for (uint64_t word : bits)
+        {
+            if (word)
+                return true;
+        }
+        return false;
+    }
+
+    int lowest() const      // First cell in row order, -1 when empty
+    {
+        for (int i = 0; i < size.words(); ++i)
+        {
+            if (bits[i])
+                return i * 64 + lowestBit(bits[i]);
+        }
+        return -1;
+    }
+
+    Bitboard &operator|=(const Bitboard &other)
+    {
+        for (int i = 0; i < size.words(); ++i)
+            bits[i] |= other.bits[i];
+        return *this;
+    }
+
+    Bitboard &operator&=(const Bitboard &other)
+    {
+        for (int i = 0; i < size.words(); ++i)
+            bits[i] &= other.bits[i];
+        return *this;
+    }
+
+    Bitboard &andNot(const Bitboard &other)
+    {
+        for (int i = 0; i < size.words(); ++i)
+            bits[i] &= ~other.bits[i];
+        return *this;
+    }
+
+    // Calls visit(cell) for every set cell in row order
+    template <typename Visit>
+    void forEach(Visit visit) const
+    {
+        for (int i = 0; i < size.words(); ++i)
+        {
+            for (uint64_t word = bits[i]; word; word &= word - 1)
+                visit(i * 64 + lowestBit(word));
+        }
+    }
+
+    // This becomes from and its neighbours, within allowed. True if that isn't just from
+    bool spread(const Bitboard &from, const Bitboard &allowed);
+
+    // Grows this within allowed until it stops growing, returns the cells covered
+    int fill(const Bitboard &allowed);
+
+private:
+    Size size;
+    typename Size::template Words<uint64_t> bits;
+};
+
+template <typename Size>
+bool Bitboard<Size>::spread(const Bitboard &from, const Bitboard &allowed)
+{
+    const int rowWords = size.rowWords();
+    const int words = size.words();
+    uint64_t changed = 0;
+
+    for (int row = 0; row < words; row += rowWords)
+    {
+        for (int column = 0; column < rowWords; ++column)
+        {
+            const int i = row + column;
+            uint64_t word = from.bits[i];
+            uint64_t grown = word | word << 1 | word >> 1;
+
+            // Bits shifted across word boundaries within the row
+            if (column > 0)
+                grown |= from.bits[i - 1] >> 63;
+            if (column + 1 < rowWords)
+                grown |= from.bits[i + 1] << 63;
+
+            if (row > 0)
+                grown |= from.bits[i - rowWords];
+            if (row + rowWords < words)
+                grown |= from.bits[i + rowWords];
+
+            grown &= allowed.bits[i];
+            changed |= grown ^ word;
+            bits[i] = grown;
+        }
+    }
+    return changed != 0;
+}
+
+template <typename Size>
+int Bitboard<Size>::fill(const Bitboard &allowed)
+{
+    *this &= allowed;
+    Bitboard next(size);
+    while (next.spread(*this, allowed))
+        std::swap(bits, next.bits);
+    return count();
+}
+
+// The game's own field, bit numbers are y * 64 + x
+typedef FixedBoardSize<FIELD_SIZE_X - 1, FIELD_SIZE_Y> FieldSize;
+typedef Bitboard<FieldSize> FieldBits;
+
+inline int fieldBit(const Point &p) { return static_cast<int>(p.y) * FieldSize::pitch() + static_cast<int>(p.x); }
+
+// Cells of the snake, kept in step with the snake list by the game
+extern thread_local FieldBits snakeCells;
+void syncSnakeCells();      // After the snake list was replaced wholesale, like after a rewind
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <iostream>
+#include "board.h"
+#include "tournament.h"
+
+typedef std::chrono::steady_clock Clock;
+
+bool findBoardBot(const std::string &name, BoardBot &bot)
+{
+    if (name == "straight")
+        bot = BoardBot::STRAIGHT;
+    else if (name == "random")
+        bot = BoardBot::RANDOM;
+    else if (name == "greedy")
+        bot = BoardBot::GREEDY;
+    else
+        return false;
+    return true;
+}
+
+std::unique_ptr<BoardEngine> createBoardEngine(int width, int height, bool dynamicOnly)
+{
+    // Every size needs a border and room for the starting snake
+    if (width < SNAKE_INIT_SIZE + 4 || height < 6 || width * height > 1 << 24)
+        return std::unique_ptr<BoardEngine>();
+
+    if (!dynamicOnly)
+    {
+        if (width == 20 && height == 15)
+            return std::unique_ptr<BoardEngine>(new Board<FixedBoardSize<20, 15>>());
+        if (width == FIELD_SIZE_X - 1 && height == FIELD_SIZE_Y)
+            return std::unique_ptr<BoardEngine>(new Board<FixedBoardSize<FIELD_SIZE_X - 1, FIELD_SIZE_Y>>());
+        if (width == 32 && height == 32)
+            return std::unique_ptr<BoardEngine>(new Board<FixedBoardSize<32, 32>>());
+        if (width == 64 && height == 64)
+            return std::unique_ptr<BoardEngine>(new Board<FixedBoardSize<64, 64>>());
+    }
+    return std::unique_ptr<BoardEngine>(new Board<DynamicBoardSize>(DynamicBoardSize(width, height)));
+}
+
+struct BenchResult {
+    unsigned long long ticks;
+    unsigned long long apples;
+    double seconds;
+};
+
+static BenchResult benchBoard(BoardEngine &board, BoardBot bot, unsigned int games, unsigned int maxTicks, unsigned int apples)
+{
+    BenchResult result = { 0, 0, 0 };
+    Clock::time_point start = Clock::now();
+    for (unsigned int seed = 1; seed <= games; ++seed)
+    {
+        board.start(seed, apples);
+        result.ticks += board.play(bot, maxTicks);
+        result.apples += board.applesEaten();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+int runBoardBenchmark(const Args &args)
+{
+    BoardBot bot;
+    if (!findBoardBot(args.value("--board-bot", "greedy"), bot))
+    {
+        std::cerr << "Unknown board bot: " << args.value("--board-bot", "greedy") << std::endl;
+        return 1;
+    }
+
+    unsigned int games = static_cast<unsigned int>(args.intValue("--games", 200));
+    unsigned int maxTicks = static_cast<unsigned int>(args.intValue("--max-ticks", 10000));
+    unsigned int apples = static_cast<unsigned int>(args.intValue("--apples", 1));
+
+    for (auto &name : splitList(args.value("--sizes", "20x15,26x16,32x32,64x64")))
+    {
+        int width = 0, height = 0;
+        std::string::size_type x = name.find('x');
+        if (x != std::string::npos)
+        {
+            width = atoi(name.substr(0, x).c_str());
+            height = atoi(name.substr(x + 1).c_str());
+        }
+
+        std::unique_ptr<BoardEngine> picked = createBoardEngine(width, height);
+        std::unique_ptr<BoardEngine> dynamic = createBoardEngine(width, height, true);
+        if (!picked)
+        {
+            std::cerr << "Bad board size: " << name << std::endl;
+            return 1;
+        }
+
+        // Same games on both, so the totals must agree
+        BenchResult fast = benchBoard(*picked, bot, games, maxTicks, apples);
+        BenchResult slow = picked->isFixed() ? benchBoard(*dynamic, bot, games, maxTicks, apples) : fast;
+
+        std::cout << name << (picked->isFixed() ? " fixed: " : " dynamic: ") << games << " games, "
+                  << fast.ticks << " ticks, " << fast.apples << " apples, "
+                  << static_cast<unsigned long long>(fast.ticks / (fast.seconds > 0 ? fast.seconds : 1)) << " ticks/s";
+        if (picked->isFixed())
+        {
+            std::cout << ", dynamic " << static_cast<unsigned long long>(slow.ticks / (slow.seconds > 0 ? slow.seconds : 1))
+                      << " ticks/s, x" << (fast.seconds > 0 ? slow.seconds / fast.seconds : 1);
+        }
+        std::cout << std::endl;
+
+        if (fast.ticks != slow.ticks || fast.apples != slow.apples)
+        {
+            std::cerr << name << ": fixed and dynamic boards played different games" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
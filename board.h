@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "args.h"
+#include "bitboard.h"
+#include "snake.h"
+#include "spawn.h"
+
+/**
+* The game rules on bitboards, at any board size, for batch simulation.
+* Walls, apples and the snake's cells are bitboards (see bitboard.h), the
+* snake itself is a ring of cell numbers. Collisions are single bit tests,
+* apple reachability comes from flood filled areas and the greedy bot's
+* distances from a breadth first search that spreads whole bitboards on
+* boards up to 64 columns wide.
+*
+* Board<Size> is written once: with FixedBoardSize<W, H> width and height are
+* compile time constants, so index math and array sizes fold away, and with
+* DynamicBoardSize the same code works on sizes only known at run time.
+* createBoardEngine() picks a fixed specialization for the common sizes.
+*
+* At the game's own size with the same seed, a board plays exactly the game
+* from snake.h, random draws included, see the "board" lockstep engine.
+*/
+enum class BoardBot {
+    STRAIGHT,
+    RANDOM,
+    GREEDY,
+};
+
+bool findBoardBot(const std::string &name, BoardBot &bot);
+
+// Same order as ALL_MOVES: up, down, left, right
+const DirectionX BOARD_MOVE_X[4] = { DirectionX::NONE, DirectionX::NONE, DirectionX::LEFT, DirectionX::RIGHT };
+const DirectionY BOARD_MOVE_Y[4] = { DirectionY::UP, DirectionY::DOWN, DirectionY::NONE, DirectionY::NONE };
+
+class BoardEngine {
+public:
+    virtual ~BoardEngine() {}
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual bool isFixed() const = 0;
+
+    // Walls around the border and the default apple rule, like initGame()
+    virtual void start(unsigned int seed, unsigned int apples) = 0;
+    // Swaps in a level like initLevel(), only levels without spawn weights at the game's own size
+    virtual bool loadLevel(const GameFieldArray &level) = 0;
+
+    virtual bool step(BoardBot bot) = 0;        // False on a crash
+    virtual unsigned int play(BoardBot bot, unsigned int maxTicks) = 0;     // Whole game, returns its ticks
+
+    virtual unsigned int tick() const = 0;
+    virtual unsigned int applesEaten() const = 0;
+    virtual bool crashed() const = 0;
+
+    // The state as the game in snake.h keeps it, false unless at the game's own size
+    virtual bool toGame(GameFieldArray &field, Snake &snake) const = 0;
+};
+
+// Fixed specialization for 20x15, 26x16 (the game), 32x32 and 64x64, dynamic for the rest
+std::unique_ptr<BoardEngine> createBoardEngine(int width, int height, bool dynamicOnly = false);
+
+// "--bench-board [--sizes 20x15,32x32,64x64] [--games N] [--max-ticks N] [--apples N] [--board-bot name]"
+int runBoardBenchmark(const Args &args);
+
+
+template <typename Size>
+class Board : public BoardEngine {
+public:
+    static const uint16_t UNREACHABLE = 0xFFFF;
+
+    explicit Board(const Size &boardSize = Size());
+
+    int width() const override { return size.width(); }
+    int height() const override { return size.height(); }
+    bool isFixed() const override { return Size::isFixed(); }
+
+    void start(unsigned int seed, unsigned int apples) override;
+    bool loadLevel(const GameFieldArray &level) override;
+
+    bool step(BoardBot bot) override;
+    unsigned int play(BoardBot bot, unsigned int maxTicks) override;
+
+    unsigned int tick() const override { return ticks; }
+    unsigned int applesEaten() const override { return eaten; }
+    bool crashed() const override { return hasCrashed; }
+
+    bool toGame(GameFieldArray &field, Snake &snake) const override;
+
+private:
+    template <typename T> using Cells = typename Size::template Cells<T>;
+
+    int index(int x, int y) const { return y * size.pitch() + x; }
+    int cellX(int cell) const { return cell % size.pitch(); }
+    int cellY(int cell) const { return cell / size.pitch(); }
+    int delta(DirectionX dx, DirectionY dy) const { return static_cast<int>(dx) + static_cast<int>(dy) * size.pitch(); }
+
+    int head() const { return snake[first]; }
+    int tail() const { return snake[(first + length - 1) % size.cells()]; }
+    void pushFront(int cell);
+    void pushBack(int cell);
+    int popBack();
+
+    unsigned int random(unsigned int min, unsigned int max);
+
+    void setWalls();
+    bool canPlaceApple(int cell, int from) const;
+    bool addApple(int from);
+    void spawnApples(int from);
+    bool nearestApple(int from, int &apple) const;
+    void distancesFrom(int apple);
+
+    bool isSafe(int cell) const { return !walls.test(cell) && !body.test(cell); }
+    void decideRandom();
+    void decideGreedy();
+
+    Size size;
+    std::mt19937 randomEngine;
+
+    Bitboard<Size> walls;
+    Bitboard<Size> open;            // Not a wall
+    Bitboard<Size> appleCells;
+    Bitboard<Size> body;            // Snake cells, a crash is the head going onto one of them
+    Cells<int> snake;               // Ring of cell numbers, head first
+    Cells<int> area;                // Connected area of open cells, apples only go where the head can get
+    Cells<uint16_t> distance;       // Steps to distanceTarget around the walls
+    int first;
+    int length;
+    DirectionX dirX;
+    DirectionY dirY;
+
+    std::vector<int> apples;
+    std::vector<int> queue;
+    unsigned int appleTarget;
+    int distanceTarget;
+
+    unsigned int ticks;
+    unsigned int eaten;
+    bool hasCrashed;
+};
+
+template <typename Size>
+const uint16_t Board<Size>::UNREACHABLE;
+
+template <typename Size>
+Board<Size>::Board(const Size &boardSize)
+    : size(boardSize), walls(boardSize), open(boardSize), appleCells(boardSize), body(boardSize),
+      first(0), length(0), dirX(DirectionX::LEFT), dirY(DirectionY::NONE),
+      appleTarget(1), distanceTarget(-1), ticks(0), eaten(0), hasCrashed(false)
+{
+    size.allocate(snake, size.cells());
+    size.allocate(area, size.cells());
+    size.allocate(distance, size.cells());
+}
+
+template <typename Size>
+unsigned int Board<Size>::random(unsigned int min, unsigned int max)
+{
+    // Same draws as random() in the game
+    unsigned int rnd = static_cast<unsigned int>(randomEngine());
+    return rnd % (max - min) + min;
+}
+
+template <typename Size>
+void Board<Size>::start(unsigned int seed, unsigned int appleCount)
+{
+    const int w = size.width(), h = size.height();
+    randomEngine.seed(seed);
+    appleTarget = appleCount;
+    ticks = 0;
+    eaten = 0;
+    hasCrashed = false;
+
+    walls.clear();
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            if (x == 0 || y == 0 || x == w - 1 || y == h - 1)
+                walls.set(index(x, y));
+        }
+    }
+
+    // Head in the middle, body to the right, heading left, like initSnake()
+    body.clear();
+    first = 0;
+    length = 0;
+    dirX = DirectionX::LEFT;
+    dirY = DirectionY::NONE;
+    const int headX = (w + 1 - SNAKE_INIT_SIZE) / 2;
+    for (int i = 0; i < SNAKE_INIT_SIZE; ++i)
+        pushBack(index(headX + i, h / 2));
+
+    setWalls();
+}
+
+template <typename Size>
+bool Board<Size>::loadLevel(const GameFieldArray &level)
+{
+    if (size.width() != FIELD_SIZE_X - 1 || size.height() != FIELD_SIZE_Y)
+        return false;
+
+    for (int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            if (spawnWeight(level[y][x]) >= 0)
+                return false;
+            if (level[y][x] == FIELD_CHAR_WALL && body.test(index(x, y)))
+                return false;
+        }
+    }
+
+    walls.clear();
+    for (int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            if (level[y][x] == FIELD_CHAR_WALL)
+                walls.set(index(x, y));
+        }
+    }
+
+    setWalls();
+    return true;
+}
+
+// New walls: label the areas, drop the apples and spawn new ones like initLevel()
+template <typename Size>
+void Board<Size>::setWalls()
+{
+    open.clear();
+    for (int y = 0; y < size.height(); ++y)
+    {
+        for (int x = 0; x < size.width(); ++x)
+        {
+            if (!walls.test(index(x, y)))
+                open.set(index(x, y));
+        }
+    }
+
+    std::fill(area.begin(), area.end(), -1);
+    Bitboard<Size> left = open;
+    Bitboard<Size> region(size);
+    for (int label = 0, seed = left.lowest(); seed >= 0; ++label, seed = left.lowest())
+    {
+        region.clear();
+        region.set(seed);
+        region.fill(left);
+        region.forEach([&](int cell) { area[cell] = label; });
+        left.andNot(region);
+    }
+
+    appleCells.clear();
+    apples.clear();
+    distanceTarget = -1;
+    spawnApples(head());
+}
+
+template <typename Size>
+void Board<Size>::pushFront(int cell)
+{
+    first = (first + size.cells() - 1) % size.cells();
+    snake[first] = cell;
+    length++;
+    body.set(cell);
+}
+
+template <typename Size>
+void Board<Size>::pushBack(int cell)
+{
+    snake[(first + length) % size.cells()] = cell;
+    length++;
+    body.set(cell);
+}
+
+template <typename Size>
+int Board<Size>::popBack()
+{
+    int cell = tail();
+    length--;
+    body.reset(cell);
+    return cell;
+}
+
+template <typename Size>
+bool Board<Size>::canPlaceApple(int cell, int from) const
+{
+    return open.test(cell) && !appleCells.test(cell) && !body.test(cell) && area[cell] == area[from];
+}
+
+template <typename Size>
+bool Board<Size>::addApple(int from)
+{
+    const int w = size.width(), h = size.height();
+
+    // Same picks as addApple() with the default AppleSpawner
+    Point apple;
+    int attempts = 0;
+    do
+    {
+        apple = Point(random(2, w - 1), random(h / 2, h - 2));
+    } while (!canPlaceApple(index(apple.x, apple.y), from) && ++attempts < 64);
+
+    int cell = index(apple.x, apple.y);
+    if (attempts == 64)
+    {
+        std::vector<int> free;
+        for (int y = h / 2; y < h - 2; ++y)
+        {
+            for (int x = 2; x < w - 1; ++x)
+            {
+                if (canPlaceApple(index(x, y), from))
+                    free.push_back(index(x, y));
+            }
+        }
+        if (free.empty())
+            return false;
+        cell = free[random(0, static_cast<unsigned int>(free.size()))];
+    }
+
+    appleCells.set(cell);
+    apples.push_back(cell);
+    return true;
+}
+
+template <typename Size>
+void Board<Size>::spawnApples(int from)
+{
+    while (apples.size() < appleTarget && addApple(from))
+        ;
+}
+
+template <typename Size>
+bool Board<Size>::nearestApple(int from, int &apple) const
+{
+    // Ties go to the first apple in row order, which is the lower cell number
+    const int fx = cellX(from), fy = cellY(from);
+    int best = -1;
+    for (int cell : apples)
+    {
+        int dist = std::abs(cellX(cell) - fx) + std::abs(cellY(cell) - fy);
+        if (best < 0 || dist < best || (dist == best && cell < apple))
+        {
+            best = dist;
+            apple = cell;
+        }
+    }
+    return best >= 0;
+}
+
+template <typename Size>
+void Board<Size>::distancesFrom(int apple)
+{
+    if (apple == distanceTarget)
+        return;
+    distanceTarget = apple;
+
+    std::fill(distance.begin(), distance.end(), UNREACHABLE);
+    distance[apple] = 0;
+
+    // A whole ring of cells per step pays off while a row is one word,
+    // wider boards have more words per ring than cells in it and use a queue
+    if (size.rowWords() == 1)
+    {
+        Bitboard<Size> frontier(size), next(size);
+        Bitboard<Size> unreached = open;
+        frontier.set(apple);
+        unreached.reset(apple);
+        for (uint16_t steps = 1; next.spread(frontier, unreached); ++steps)
+        {
+            next.forEach([&](int cell) { distance[cell] = steps; });
+            unreached.andNot(next);
+            std::swap(frontier, next);
+        }
+        return;
+    }
+
+    queue.clear();
+    queue.push_back(apple);
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        const int cell = queue[i];
+        const int around[4] = { cell - size.pitch(), cell + size.pitch(), cell - 1, cell + 1 };
+        for (int next : around)
+        {
+            if (open.test(next) && distance[next] == UNREACHABLE)
+            {
+                distance[next] = static_cast<uint16_t>(distance[cell] + 1);
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+template <typename Size>
+void Board<Size>::decideRandom()
+{
+    int safe[4];
+    unsigned int count = 0;
+    for (int m = 0; m < 4; ++m)
+    {
+        if (isSafe(head() + delta(BOARD_MOVE_X[m], BOARD_MOVE_Y[m])))
+            safe[count++] = m;
+    }
+
+    if (count > 0)
+    {
+        int m = safe[random(0, count)];
+        dirX = BOARD_MOVE_X[m];
+        dirY = BOARD_MOVE_Y[m];
+    }
+}
+
+template <typename Size>
+void Board<Size>::decideGreedy()
+{
+    int apple = -1;
+    if (!nearestApple(head(), apple))
+        return decideRandom();
+    distancesFrom(apple);
+
+    int best = -1;
+    uint16_t bestDist = 0;
+    for (int m = 0; m < 4; ++m)
+    {
+        int next = head() + delta(BOARD_MOVE_X[m], BOARD_MOVE_Y[m]);
+        if (!isSafe(next))
+            continue;
+        if (best < 0 || distance[next] < bestDist)
+        {
+            best = m;
+            bestDist = distance[next];
+        }
+    }
+
+    if (best >= 0)
+    {
+        dirX = BOARD_MOVE_X[best];
+        dirY = BOARD_MOVE_Y[best];
+    }
+}
+
+template <typename Size>
+bool Board<Size>::step(BoardBot bot)
+{
+    if (bot == BoardBot::RANDOM)
+        decideRandom();
+    else if (bot == BoardBot::GREEDY)
+        decideGreedy();
+
+    // Same order as moveSnake(): the tail leaves first, a new apple may go anywhere
+    // the new head isn't yet, the old head decides what counts as reachable
+    const int oldHead = head();
+    const int back = popBack();
+    const int next = oldHead + delta(dirX, dirY);
+
+    if (appleCells.test(next))
+    {
+        appleCells.reset(next);
+        for (size_t i = 0; i < apples.size(); ++i)
+        {
+            if (apples[i] == next)
+            {
+                apples[i] = apples.back();
+                apples.pop_back();
+                break;
+            }
+        }
+        eaten++;
+        pushBack(back);
+        spawnApples(oldHead);
+    }
+
+    hasCrashed = walls.test(next) || body.test(next);
+    pushFront(next);
+    ticks++;
+    return !hasCrashed;
+}
+
+template <typename Size>
+unsigned int Board<Size>::play(BoardBot bot, unsigned int maxTicks)
+{
+    while (ticks < maxTicks && step(bot))
+        ;
+    return ticks;
+}
+
+template <typename Size>
+bool Board<Size>::toGame(GameFieldArray &field, Snake &snakeList) const
+{
+    if (size.width() != FIELD_SIZE_X - 1 || size.height() != FIELD_SIZE_Y)
+        return false;
+
+    for (int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            int cell = index(x, y);
+            field[y][x] = walls.test(cell) ? FIELD_CHAR_WALL : appleCells.test(cell) ? FIELD_CHAR_APPLE : FIELD_CHAR_EMPTY;
+        }
+        field[y][FIELD_SIZE_X - 1] = '\0';
+    }
+
+    snakeList.clear();
+    for (int i = 0; i < length; ++i)
+    {
+        int cell = snake[(first + i) % size.cells()];
+        snakeList.push_back(SnakeSegment(cellX(cell), cellY(cell), DirectionX::NONE, DirectionY::NONE));
+    }
+    snakeList.front().dirX = dirX;
+    snakeList.front().dirY = dirY;
+    return true;
+}
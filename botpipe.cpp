@@ -0,0 +1,162 @@
+#include "botpipe.h"
+
+const size_t BOT_READ_CHUNK = 64 * 1024;
+
+BotPipe::BotPipe() : frameStart(0), countPos(0), cellCount(0), inPos(0), movePos(0)
+{
+    outBuf.reserve(BOT_READ_CHUNK);
+    inBuf.reserve(BOT_READ_CHUNK);
+}
+
+bool BotPipe::start(const char* command)
+{
+    outBuf.clear();
+    inBuf.clear();
+    moves.clear();
+    inPos = movePos = 0;
+    return process.start(command);
+}
+
+void BotPipe::stop()
+{
+    flush();
+    process.wait();
+}
+
+void BotPipe::putU16(unsigned int value)
+{
+    outBuf.push_back(static_cast<unsigned char>(value & 0xFF));
+    outBuf.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
+}
+
+void BotPipe::putU32(unsigned int value)
+{
+    putU16(value & 0xFFFF);
+    putU16(value >> 16);
+}
+
+void BotPipe::beginFrame(unsigned char type, unsigned int tick)
+{
+    frameStart = outBuf.size();
+    putU32(0);              // Length, patched in endFrame()
+    outBuf.push_back(type);
+    putU32(tick);
+}
+
+void BotPipe::endFrame()
+{
+    outBuf[countPos] = static_cast<unsigned char>(cellCount & 0xFF);
+    outBuf[countPos + 1] = static_cast<unsigned char>((cellCount >> 8) & 0xFF);
+
+    size_t length = outBuf.size() - frameStart - 4;
+    for (int i = 0; i < 4; ++i)
+        outBuf[frameStart + i] = static_cast<unsigned char>((length >> (8 * i)) & 0xFF);
+}
+
+void BotPipe::putCell(unsigned int x, unsigned int y, char ch)
+{
+    outBuf.push_back(static_cast<unsigned char>(x));
+    outBuf.push_back(static_cast<unsigned char>(y));
+    outBuf.push_back(static_cast<unsigned char>(ch));
+    cellCount++;
+}
+
+void BotPipe::sendReset(unsigned int tick)
+{
+    beginFrame(BOT_FRAME_RESET, tick);
+    outBuf.push_back(static_cast<unsigned char>(FIELD_SIZE_X - 1));
+    outBuf.push_back(static_cast<unsigned char>(FIELD_SIZE_Y));
+    countPos = outBuf.size();
+    cellCount = 0;
+    putU16(0);
+
+    for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+            putCell(x, y, gameField[y][x]);
+    }
+    for (auto &segm : snake)
+        putCell(segm.x, segm.y, FIELD_CHAR_SNAKE);
+
+    endFrame();
+}
+
+void BotPipe::sendTick(unsigned int tick, const FieldChanges &changes)
+{
+    beginFrame(BOT_FRAME_TICK, tick);
+    countPos = outBuf.size();
+    cellCount = 0;
+    putU16(0);
+
+    for (auto &change : changes)
+        putCell(change.p.x, change.p.y, change.ch);
+
+    endFrame();
+}
+
+void BotPipe::sendGameOver(unsigned int tick)
+{
+    beginFrame(BOT_FRAME_GAME_OVER, tick);
+    countPos = outBuf.size();
+    cellCount = 0;
+    putU16(0);
+    endFrame();
+}
+
+bool BotPipe::flush()
+{
+    if (outBuf.empty() || !process.isRunning())
+        return process.isRunning();
+
+    bool ok = process.writeAll(outBuf.data(), outBuf.size());
+    outBuf.clear();
+    return ok;
+}
+
+bool BotPipe::readMoves()
+{
+    moves.clear();
+    movePos = 0;
+
+    while (moves.empty())
+    {
+        // Parse every complete frame we already have
+        while (inBuf.size() - inPos >= 4)
+        {
+            const unsigned char* p = inBuf.data() + inPos;
+            size_t length = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<size_t>(p[3]) << 24);
+            if (inBuf.size() - inPos - 4 < length)
+                break;
+
+            moves.insert(moves.end(), p + 4, p + 4 + length);
+            inPos += 4 + length;
+        }
+
+        if (!moves.empty())
+            break;
+
+        // Drop consumed bytes and read the next chunk
+        inBuf.erase(inBuf.begin(), inBuf.begin() + inPos);
+        inPos = 0;
+
+        size_t used = inBuf.size();
+        inBuf.resize(used + BOT_READ_CHUNK);
+        long got = process.readSome(inBuf.data() + used, BOT_READ_CHUNK);
+        inBuf.resize(used + (got > 0 ? got : 0));
+        if (got <= 0)
+            return false;
+    }
+
+    return true;
+}
+
+char BotPipe::nextMove()
+{
+    if (movePos == moves.size())
+    {
+        if (!flush() || !readMoves())
+            return 0;
+    }
+
+    return moves[movePos++];
+}
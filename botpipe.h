@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "process.h"
+#include "snake.h"
+
+/**
+* Bot connected over a pipe to a child process.
+*
+* Every frame in both directions is a little-endian u32 payload length
+* followed by the payload.
+*
+* Game -> bot payload:
+*   u8 type (BOT_FRAME_*), u32 tick,
+*   reset frame only: u8 width, u8 height,
+*   u16 count, then count cells of {u8 x, u8 y, u8 char}.
+* A reset frame carries the whole field with the snake drawn on it,
+* tick frames carry only the cells changed during that tick.
+*
+* Bot -> game payload: one byte per tick, 'U', 'D', 'L', 'R' to turn
+* or '.' to keep going. Sending several bytes plans several ticks ahead.
+*
+* Tick frames are only flushed when the bot has run out of moves,
+* so a bot that plans k ticks ahead costs one write and one read per k ticks.
+*/
+const unsigned char BOT_FRAME_RESET = 0;
+const unsigned char BOT_FRAME_TICK = 1;
+const unsigned char BOT_FRAME_GAME_OVER = 2;
+
+class BotPipe {
+public:
+    BotPipe();
+
+    bool start(const char* command);
+    void stop();
+
+    bool isRunning() const { return process.isRunning(); }
+
+    void sendReset(unsigned int tick);
+    void sendTick(unsigned int tick, const FieldChanges &changes);
+    void sendGameOver(unsigned int tick);
+
+    // Returns next planned move or 0 if the bot is gone
+    char nextMove();
+
+private:
+    void beginFrame(unsigned char type, unsigned int tick);
+    void endFrame();
+    void putCell(unsigned int x, unsigned int y, char ch);
+    void putU16(unsigned int value);
+    void putU32(unsigned int value);
+
+    bool flush();
+    bool readMoves();
+
+    ChildProcess process;
+
+    std::vector<unsigned char> outBuf;
+    size_t frameStart;
+    size_t countPos;
+    unsigned int cellCount;
+
+    std::vector<unsigned char> inBuf;
+    size_t inPos;
+
+    std::vector<char> moves;
+    size_t movePos;
+};
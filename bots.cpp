@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include "bots.h"
+#include "mlp.h"
+#include "distfield.h"
+#include "dstar.h"
+#include "safety.h"
+#include "apples.h"
+
+// --train --population 64 --generations 30 --games 8 --seed 1, rounded
+BotWeights defaultBotWeights = {{ 3.0, 0.057, 2.7, -0.03 }};
+thread_local BotWeights botWeights = defaultBotWeights;
+
+const Move ALL_MOVES[4] = {
+    { DirectionX::NONE, DirectionY::UP },
+    { DirectionX::NONE, DirectionY::DOWN },
+    { DirectionX::LEFT, DirectionY::NONE },
+    { DirectionX::RIGHT, DirectionY::NONE },
+};
+
+Point applyMove(const Point &p, const Move &move)
+{
+    return Point(p.x + static_cast<unsigned int>(move.dirX), p.y + static_cast<unsigned int>(move.dirY));
+}
+
+bool isSafeCell(const Point &p)
+{
+    return !isWall(p) && !checkCollisionWithSnake(p);
+}
+
+unsigned int distanceTo(const Point &from, const Point &to)
+{
+    if (levelDistances)
+        return levelDistances->distance(from, to);
+    return std::abs(static_cast<int>(from.x) - static_cast<int>(to.x))
+         + std::abs(static_cast<int>(from.y) - static_cast<int>(to.y));
+}
+
+bool findApple(Point &apple)
+{
+    return apples.nearest(snake.front(), apple);
+}
+
+unsigned int reachableArea(const Point &from)
+{
+    return checkMoveSafety(from).area;
+}
+
+// Never turns, the baseline every other bot should beat
+void straightBot()
+{
+}
+
+// Random move that doesn't crash right away
+void randomBot()
+{
+    const Point head = snake.front();
+    Move safe[4];
+    unsigned int count = 0;
+
+    for (auto &move : ALL_MOVES)
+    {
+        if (isSafeCell(applyMove(head, move)))
+            safe[count++] = move;
+    }
+
+    if (count > 0)
+    {
+        const Move &move = safe[random(0, count)];
+        setSnakeDirection(move.dirX, move.dirY);
+    }
+}
+
+// Safe move that gets closest to the apple
+void greedyBot()
+{
+    const Point head = snake.front();
+    Point apple;
+    if (!findApple(apple))
+        return randomBot();
+
+    const Move* best = nullptr;
+    unsigned int bestDist = 0;
+    for (auto &move : ALL_MOVES)
+    {
+        Point next = applyMove(head, move);
+        if (!isSafeCell(next))
+            continue;
+
+        unsigned int dist = distanceTo(next, apple);
+        if (!best || dist < bestDist)
+        {
+            best = &move;
+            bestDist = dist;
+        }
+    }
+
+    if (best)
+        setSnakeDirection(best->dirX, best->dirY);
+}
+
+// Picks the safe move with the best weighted sum of features
+void weightedBot()
+{
+    const SnakeSegment &head = snake.front();
+    Point apple;
+    bool hasApple = findApple(apple);
+    const double maxDist = FIELD_SIZE_X + FIELD_SIZE_Y;
+    const double maxArea = (FIELD_SIZE_X - 1) * FIELD_SIZE_Y;
+
+    const Move* best = nullptr;
+    double bestScore = 0;
+    for (auto &move : ALL_MOVES)
+    {
+        Point next = applyMove(head, move);
+        if (!isSafeMove(next))
+            continue;
+
+        double closeness = 0;
+        if (hasApple)
+        {
+            unsigned int dist = distanceTo(next, apple);
+            closeness = dist == DIST_UNREACHABLE ? 0.0 : 1.0 - std::min(dist / maxDist, 1.0);
+        }
+
+        unsigned int freeNeighbours = 0;
+        for (auto &around : ALL_MOVES)
+        {
+            if (isSafeMove(applyMove(next, around)))
+                freeNeighbours++;
+        }
+
+        double area = reachableArea(next) / maxArea;
+        double straight = move.dirX == head.dirX && move.dirY == head.dirY ? 1.0 : 0.0;
+
+        double score = botWeights[0] * closeness + botWeights[1] * freeNeighbours / 4.0
+                     + botWeights[2] * area + botWeights[3] * straight;
+        if (!best || score > bestScore)
+        {
+            best = &move;
+            bestScore = score;
+        }
+    }
+
+    if (best)
+        setSnakeDirection(best->dirX, best->dirY);
+}
+
+// Follows the incrementally repaired D* Lite path to the apple
+void dstarBot()
+{
+    const Point head = snake.front();
+    Point next;
+    if (!plannedStep(next))
+        return weightedBot();
+
+    for (auto &move : ALL_MOVES)
+    {
+        Point candidate = applyMove(head, move);
+        if (candidate.x == next.x && candidate.y == next.y)
+        {
+            // Path into a dead end is worse than no path at all
+            if (reachableArea(next) < snake.size())
+                return weightedBot();
+            setSnakeDirection(move.dirX, move.dirY);
+            return;
+        }
+    }
+}
+
+// Asks the policy network, falls back to greedy when no network is loaded
+void mlpBot()
+{
+    if (policyNet.inputCount() == 0)
+        return greedyBot();
+
+    static thread_local std::vector<float> input;
+    input.resize(policyNet.paddedInputCount());
+    float output[MLP_OUTPUTS];
+
+    mlpInput(input.data());
+    policyNet.forwardBatch(input.data(), 1, output);
+
+    const Point head = snake.front();
+    int best = -1;
+    for (int i = 0; i < MLP_OUTPUTS; ++i)
+    {
+        if (isSafeMove(applyMove(head, ALL_MOVES[i])) && (best < 0 || output[i] > output[best]))
+            best = i;
+    }
+
+    if (best >= 0)
+        setSnakeDirection(ALL_MOVES[best].dirX, ALL_MOVES[best].dirY);
+}
+
+bool loadBotWeights(const std::string &file, BotWeights &weights)
+{
+    std::ifstream in(file);
+    BotWeights loaded;
+    for (auto &w : loaded)
+    {
+        if (!(in >> w))
+            return false;
+    }
+    weights = loaded;
+    return true;
+}
+
+bool saveBotWeights(const std::string &file, const BotWeights &weights)
+{
+    std::ofstream out(file);
+    out.precision(17);
+    for (auto w : weights)
+        out << w << '\n';
+    return static_cast<bool>(out);
+}
+
+const std::vector<BotInfo>& getBots()
+{
+    static const std::vector<BotInfo> bots = {
+        { "straight", straightBot },
+        { "random", randomBot },
+        { "greedy", greedyBot },
+        { "weighted", weightedBot },
+        { "mlp", mlpBot },
+        { "dstar", dstarBot },
+    };
+    return bots;
+}
+
+const BotInfo* findBot(const std::string &name)
+{
+    for (auto &bot : getBots())
+    {
+        if (name == bot.name)
+            return &bot;
+    }
+    return nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "snake.h"
+
+/**
+* Built-in bot strategies.
+* A bot looks at the current game state and turns the snake
+* with setSnakeDirection(), exactly where a player would press a key.
+*/
+typedef void (*BotFunc)();
+
+struct BotInfo {
+    const char* name;
+    BotFunc decide;
+};
+
+const std::vector<BotInfo>& getBots();
+const BotInfo* findBot(const std::string &name);
+
+// Helpers shared by bot strategies
+struct Move {
+    DirectionX dirX;
+    DirectionY dirY;
+};
+
+extern const Move ALL_MOVES[4];
+
+Point applyMove(const Point &p, const Move &move);
+bool isSafeCell(const Point &p);
+bool findApple(Point &apple);     // Nearest apple to the head
+unsigned int distanceTo(const Point &from, const Point &to);   // Path length ignoring the snake
+unsigned int reachableArea(const Point &from);
+
+/**
+* Weights of the "weighted" bot, one per feature of a candidate move:
+* closeness to the apple, free neighbours, reachable area and keeping direction.
+* Each thread starts with a copy of defaultBotWeights.
+*/
+const int BOT_WEIGHT_COUNT = 4;
+typedef std::array<double, BOT_WEIGHT_COUNT> BotWeights;
+
+extern BotWeights defaultBotWeights;
+extern thread_local BotWeights botWeights;
+
+bool loadBotWeights(const std::string &file, BotWeights &weights);
+bool saveBotWeights(const std::string &file, const BotWeights &weights);
@@ -0,0 +1,187 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "distfield.h"
+
+const char DIST_MAGIC[8] = { 'S', 'N', 'K', 'D', 'I', 'S', 'T', '1' };
+const size_t DIST_CACHE_SIZE = 16;     // Fields kept in memory, hot reloads and level packs go through many
+
+std::string distanceCacheDir;
+unsigned int distanceThreads = 1;
+
+thread_local const DistanceField* levelDistances = nullptr;
+static thread_local std::shared_ptr<const DistanceField> heldDistances;     // Keeps levelDistances alive after eviction
+
+DistanceField::DistanceField() : levelHash(0), freeCells(0)
+{
+}
+
+uint64_t DistanceField::hashLevel(const GameFieldArray &level)
+{
+    // FNV-1a over the wall map
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto &row : level)
+    {
+        for (GameFieldArray::size_type x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            hash ^= row[x] == FIELD_CHAR_WALL ? 1 : 0;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+void DistanceField::indexCells(const GameFieldArray &level)
+{
+    levelHash = hashLevel(level);
+    cellIndex.assign(FIELD_SIZE_X * FIELD_SIZE_Y, -1);
+    cells.clear();
+
+    for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            if (level[y][x] != FIELD_CHAR_WALL)
+            {
+                cellIndex[y * FIELD_SIZE_X + x] = static_cast<int>(cells.size());
+                cells.push_back(Point(x, y));
+            }
+        }
+    }
+    freeCells = static_cast<int>(cells.size());
+}
+
+void DistanceField::build(const GameFieldArray &level, unsigned int threads)
+{
+    indexCells(level);
+    dist.assign(static_cast<size_t>(freeCells) * freeCells, DIST_UNREACHABLE);
+
+    const int neighbours[4] = { -FIELD_SIZE_X, FIELD_SIZE_X, -1, 1 };
+    std::atomic<int> nextSource(0);
+
+    auto worker = [&]()
+    {
+        std::vector<int> queue(freeCells);
+        for (int source = nextSource++; source < freeCells; source = nextSource++)
+        {
+            uint16_t* row = &dist[static_cast<size_t>(source) * freeCells];
+            size_t head = 0, tail = 0;
+            queue[tail++] = source;
+            row[source] = 0;
+
+            while (head < tail)
+            {
+                int cell = queue[head++];
+                const Point &p = cells[cell];
+                int fieldIndex = p.y * FIELD_SIZE_X + p.x;
+                for (int offset : neighbours)
+                {
+                    int next = fieldIndex + offset;
+                    if (next < 0 || next >= FIELD_SIZE_X * FIELD_SIZE_Y)
+                        continue;
+                    int nextCell = cellIndex[next];
+                    if (nextCell >= 0 && row[nextCell] == DIST_UNREACHABLE)
+                    {
+                        row[nextCell] = row[cell] + 1;
+                        queue[tail++] = nextCell;
+                    }
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; ++i)
+        pool.push_back(std::thread(worker));
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+}
+
+bool DistanceField::load(const std::string &file, const GameFieldArray &level)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(DIST_MAGIC)];
+    uint64_t hash = 0;
+    int32_t count = 0;
+    if (!in.read(magic, sizeof(magic)) || !in.read(reinterpret_cast<char*>(&hash), sizeof(hash))
+        || !in.read(reinterpret_cast<char*>(&count), sizeof(count)))
+        return false;
+
+    indexCells(level);
+    if (std::string(magic, sizeof(magic)) != std::string(DIST_MAGIC, sizeof(DIST_MAGIC))
+        || hash != levelHash || count != freeCells)
+        return false;
+
+    dist.resize(static_cast<size_t>(freeCells) * freeCells);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(dist.data()), dist.size() * sizeof(uint16_t)));
+}
+
+bool DistanceField::save(const std::string &file) const
+{
+    // Cache files are host byte order, they never leave the machine
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary);
+        int32_t count = freeCells;
+        out.write(DIST_MAGIC, sizeof(DIST_MAGIC));
+        out.write(reinterpret_cast<const char*>(&levelHash), sizeof(levelHash));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(dist.data()), dist.size() * sizeof(uint16_t));
+        if (!out)
+            return false;
+    }
+    std::remove(file.c_str());
+    return std::rename(tmpFile.c_str(), file.c_str()) == 0;
+}
+
+std::shared_ptr<const DistanceField> distanceFieldFor(const GameFieldArray &level)
+{
+    static std::mutex mutex;
+    static std::list<std::shared_ptr<const DistanceField>> cache;     // Most recently used first
+
+    uint64_t hash = DistanceField::hashLevel(level);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+    {
+        if ((*it)->hash() == hash)
+        {
+            cache.splice(cache.begin(), cache, it);
+            return cache.front();
+        }
+    }
+
+    std::shared_ptr<DistanceField> field(new DistanceField());
+
+    std::string file;
+    if (!distanceCacheDir.empty())
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.dist", static_cast<unsigned long long>(hash));
+        file = distanceCacheDir + name;
+    }
+
+    if (file.empty() || !field->load(file, level))
+    {
+        field->build(level, distanceThreads);
+        if (!file.empty())
+            field->save(file);
+    }
+
+    // Threads still playing on an evicted field hold their own reference
+    cache.push_front(field);
+    if (cache.size() > DIST_CACHE_SIZE)
+        cache.pop_back();
+    return field;
+}
+
+void useLevelDistances(const GameFieldArray &level)
+{
+    heldDistances = distanceFieldFor(level);
+    levelDistances = heldDistances.get();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "snake.h"
+
+/**
+* Precomputed shortest path lengths between every two free cells of a level,
+* ignoring the snake. One BFS per free cell, run in parallel.
+* Built fields are cached in memory and optionally on disk,
+* keyed by a hash of the level walls.
+*/
+const uint16_t DIST_UNREACHABLE = 0xFFFF;
+
+class DistanceField {
+public:
+    DistanceField();
+
+    void build(const GameFieldArray &level, unsigned int threads);
+    bool load(const std::string &file, const GameFieldArray &level);
+    bool save(const std::string &file) const;
+
+    uint16_t distance(const Point &from, const Point &to) const
+    {
+        int a = cellIndex[from.y * FIELD_SIZE_X + from.x];
+        int b = cellIndex[to.y * FIELD_SIZE_X + to.x];
+        if (a < 0 || b < 0)
+            return DIST_UNREACHABLE;
+        return dist[static_cast<size_t>(a) * freeCells + b];
+    }
+
+    uint64_t hash() const { return levelHash; }
+
+    static uint64_t hashLevel(const GameFieldArray &level);
+
+private:
+    void indexCells(const GameFieldArray &level);
+
+    uint64_t levelHash;
+    int freeCells;
+    std::vector<int> cellIndex;         // Field cell -> free cell number or -1 for walls
+    std::vector<Point> cells;           // Free cell number -> field cell
+    std::vector<uint16_t> dist;         // freeCells x freeCells
+};
+
+extern std::string distanceCacheDir;    // Empty - memory cache only
+extern unsigned int distanceThreads;
+
+// Distance field of the current level, set by useLevelDistances() from initField() and initLevel()
+extern thread_local const DistanceField* levelDistances;
+
+// Built or loaded on first use, the most recently used ones stay in memory
+std::shared_ptr<const DistanceField> distanceFieldFor(const GameFieldArray &level);
+void useLevelDistances(const GameFieldArray &level);
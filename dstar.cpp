@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstdlib>
+#include "dstar.h"
+#include "bots.h"
+
+const int DSTAR_INF = 1 << 28;
+const int DSTAR_CELLS = FIELD_SIZE_X * FIELD_SIZE_Y;
+
+DStarLite::DStarLite() : start(-1), goal(-1), km(0), expanded(0)
+{
+}
+
+int DStarLite::heuristic(int a, int b) const
+{
+    return std::abs(a % FIELD_SIZE_X - b % FIELD_SIZE_X) + std::abs(a / FIELD_SIZE_X - b / FIELD_SIZE_X);
+}
+
+DStarLite::Key DStarLite::calculateKey(int cell) const
+{
+    int best = std::min(g[cell], rhs[cell]);
+    Key key = { best >= DSTAR_INF ? DSTAR_INF : best + heuristic(start, cell) + km, best };
+    return key;
+}
+
+int DStarLite::cost(int to) const
+{
+    return blocked[to] ? DSTAR_INF : 1;
+}
+
+int DStarLite::neighbours(int cell, int out[4]) const
+{
+    int count = 0;
+    int x = cell % FIELD_SIZE_X;
+    int y = cell / FIELD_SIZE_X;
+    if (y > 0)
+        out[count++] = cell - FIELD_SIZE_X;
+    if (y < FIELD_SIZE_Y - 1)
+        out[count++] = cell + FIELD_SIZE_X;
+    if (x > 0)
+        out[count++] = cell - 1;
+    if (x < FIELD_SIZE_X - 2)
+        out[count++] = cell + 1;
+    return count;
+}
+
+void DStarLite::reset(const Point &_start, const Point &_goal)
+{
+    g.assign(DSTAR_CELLS, DSTAR_INF);
+    rhs.assign(DSTAR_CELLS, DSTAR_INF);
+    open.assign(DSTAR_CELLS, false);
+    openKey.assign(DSTAR_CELLS, Key());
+    queue = std::priority_queue<OpenEntry>();
+
+    if (blocked.size() != static_cast<size_t>(DSTAR_CELLS))
+        blocked.assign(DSTAR_CELLS, false);
+
+    start = index(_start);
+    goal = index(_goal);
+    km = 0;
+
+    rhs[goal] = 0;
+    openKey[goal] = calculateKey(goal);
+    open[goal] = true;
+    OpenEntry entry = { openKey[goal], goal };
+    queue.push(entry);
+}
+
+void DStarLite::moveStart(const Point &_start)
+{
+    int cell = index(_start);
+    km += heuristic(start, cell);
+    start = cell;
+}
+
+void DStarLite::setBlocked(const Point &p, bool isBlocked)
+{
+    int cell = index(p);
+    if (blocked.size() != static_cast<size_t>(DSTAR_CELLS))
+        blocked.assign(DSTAR_CELLS, false);
+    if (blocked[cell] == isBlocked)
+        return;
+
+    blocked[cell] = isBlocked;
+    if (goal < 0)
+        return;
+
+    // Cost of every edge leading into the cell has changed
+    int around[4];
+    int count = neighbours(cell, around);
+    for (int i = 0; i < count; ++i)
+        updateVertex(around[i]);
+}
+
+void DStarLite::updateVertex(int cell)
+{
+    if (cell != goal)
+    {
+        int around[4];
+        int count = neighbours(cell, around);
+        int best = DSTAR_INF;
+        for (int i = 0; i < count; ++i)
+        {
+            int next = around[i];
+            if (cost(next) < DSTAR_INF && g[next] < DSTAR_INF)
+                best = std::min(best, cost(next) + g[next]);
+        }
+        rhs[cell] = best;
+    }
+
+    open[cell] = false;
+    if (g[cell] != rhs[cell])
+    {
+        openKey[cell] = calculateKey(cell);
+        open[cell] = true;
+        OpenEntry entry = { openKey[cell], cell };
+        queue.push(entry);
+    }
+}
+
+DStarLite::Key DStarLite::topKey()
+{
+    while (!queue.empty())
+    {
+        const OpenEntry &top = queue.top();
+        if (open[top.cell] && openKey[top.cell] == top.key)
+            return top.key;
+        queue.pop();
+    }
+    Key none = { DSTAR_INF, DSTAR_INF };
+    return none;
+}
+
+void DStarLite::computeShortestPath()
+{
+    for (;;)
+    {
+        Key top = topKey();
+        if (queue.empty() || !(top < calculateKey(start) || rhs[start] != g[start]))
+            break;
+
+        int cell = queue.top().cell;
+        queue.pop();
+        open[cell] = false;
+        expanded++;
+
+        Key newKey = calculateKey(cell);
+        if (top < newKey)
+        {
+            openKey[cell] = newKey;
+            open[cell] = true;
+            OpenEntry entry = { newKey, cell };
+            queue.push(entry);
+            continue;
+        }
+
+        int around[4];
+        int count = neighbours(cell, around);
+        if (g[cell] > rhs[cell])
+        {
+            g[cell] = rhs[cell];
+        }
+        else
+        {
+            g[cell] = DSTAR_INF;
+            updateVertex(cell);
+        }
+
+        for (int i = 0; i < count; ++i)
+            updateVertex(around[i]);
+    }
+}
+
+bool DStarLite::nextStep(Point &next)
+{
+    if (goal < 0)
+        return false;
+
+    computeShortestPath();
+
+    int around[4];
+    int count = neighbours(start, around);
+    int best = -1;
+    int bestCost = DSTAR_INF;
+    for (int i = 0; i < count; ++i)
+    {
+        int cell = around[i];
+        if (cost(cell) < DSTAR_INF && g[cell] < bestCost)
+        {
+            best = cell;
+            bestCost = g[cell];
+        }
+    }
+
+    if (best < 0)
+        return false;
+
+    next = Point(best % FIELD_SIZE_X, best / FIELD_SIZE_X);
+    return true;
+}
+
+bool plannedStep(Point &next)
+{
+    static thread_local DStarLite planner;
+    static thread_local unsigned int lastTick = 0;
+
+    Point apple;
+    if (!findApple(apple))
+        return false;
+
+    const Point head = snake.front();
+
+    if (gameTick == 0 || gameTick != lastTick + 1 || !planner.hasGoal())
+    {
+        // New game or missed ticks, start from scratch
+        for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+        {
+            for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+                planner.setBlocked(Point(x, y), gameField[y][x] == FIELD_CHAR_WALL);
+        }
+        for (auto &segm : snake)
+            planner.setBlocked(segm, true);
+        planner.reset(head, apple);
+    }
+    else if (!planner.isGoal(apple))
+    {
+        for (auto &change : fieldChanges)
+            planner.setBlocked(change.p, change.ch == FIELD_CHAR_WALL || change.ch == FIELD_CHAR_SNAKE);
+        planner.reset(head, apple);
+    }
+    else
+    {
+        // Cells taken by the head and freed by the tail during the last tick
+        planner.moveStart(head);
+        for (auto &change : fieldChanges)
+            planner.setBlocked(change.p, change.ch == FIELD_CHAR_WALL || change.ch == FIELD_CHAR_SNAKE);
+    }
+    lastTick = gameTick;
+
+    return planner.nextStep(next);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+#include "snake.h"
+
+/**
+* D* Lite path planner from the snake head to the apple.
+*
+* The search runs backwards from the apple, so when the head moves and
+* the body frees or takes a few cells only the affected part of the
+* previous search is repaired. Walls and snake cells are obstacles.
+* A new apple restarts the search, since D* Lite can't move its goal.
+*/
+class DStarLite {
+public:
+    DStarLite();
+
+    void reset(const Point &start, const Point &goal);
+    void moveStart(const Point &start);
+    void setBlocked(const Point &p, bool blocked);
+
+    bool hasGoal() const { return goal >= 0; }
+    bool isGoal(const Point &p) const { return goal == index(p); }
+
+    // Finds the next cell on the shortest path, false if the apple is unreachable
+    bool nextStep(Point &next);
+
+    unsigned long long expansions() const { return expanded; }
+
+private:
+    struct Key {
+        int k1;
+        int k2;
+        bool operator<(const Key &other) const { return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2); }
+        bool operator==(const Key &other) const { return k1 == other.k1 && k2 == other.k2; }
+    };
+
+    struct OpenEntry {
+        Key key;
+        int cell;
+        bool operator<(const OpenEntry &other) const { return other.key < key; }   // Min heap
+    };
+
+    static int index(const Point &p) { return p.y * FIELD_SIZE_X + p.x; }
+    int heuristic(int a, int b) const;
+    Key calculateKey(int cell) const;
+    int cost(int to) const;
+    int neighbours(int cell, int out[4]) const;
+
+    void updateVertex(int cell);
+    void computeShortestPath();
+    Key topKey();
+
+    std::vector<int> g;
+    std::vector<int> rhs;
+    std::vector<bool> blocked;
+    std::vector<bool> open;
+    std::vector<Key> openKey;
+    std::priority_queue<OpenEntry> queue;     // Holds stale entries, checked against openKey
+
+    int start;
+    int goal;
+    int km;
+
+    unsigned long long expanded;
+};
+
+// Keeps a per thread planner in sync with the game through fieldChanges
+bool plannedStep(Point &next);
@@ -0,0 +1,151 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include "events.h"
+
+EventBus gameEvents;
+
+struct EventBus::Subscriber {
+    Subscriber(size_t capacity, OverflowPolicy policy, Handler handler)
+        : queue(capacity), policy(policy), handler(handler), running(true), dropped(0) {}
+
+    void run()
+    {
+        GameEvent event;
+        int idle = 0;
+        for (;;)
+        {
+            if (queue.pop(event))
+            {
+                handler(event);
+                idle = 0;
+                continue;
+            }
+            if (!running.load(std::memory_order_acquire))
+            {
+                // Take whatever came in between the last pop and the stop
+                while (queue.pop(event))
+                    handler(event);
+                return;
+            }
+
+            // Spin a little, then back off so an idle subscriber costs nothing
+            if (++idle < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::string name;
+    BoundedQueue<GameEvent> queue;
+    OverflowPolicy policy;
+    Handler handler;
+    std::atomic<bool> running;
+    std::atomic<unsigned long long> dropped;
+    std::thread thread;
+};
+
+const char* eventName(GameEventType type)
+{
+    switch (type)
+    {
+    case GameEventType::APPLE_EATEN: return "apple_eaten";
+    case GameEventType::CRASH: return "crash";
+    case GameEventType::DIRECTION_CHANGE: return "direction_change";
+    case GameEventType::LEVEL_LOADED: return "level_loaded";
+    }
+    return "unknown";
+}
+
+EventBus::EventBus() : count(0)
+{
+}
+
+EventBus::~EventBus()
+{
+    stop();
+}
+
+bool EventBus::subscribe(const std::string &name, size_t capacity, OverflowPolicy policy, Handler handler)
+{
+    int n = count.load(std::memory_order_relaxed);
+    if (n >= MAX_SUBSCRIBERS)
+        return false;
+
+    subscribers[n].reset(new Subscriber(capacity, policy, handler));
+    subscribers[n]->name = name;
+    subscribers[n]->thread = std::thread(&Subscriber::run, subscribers[n].get());
+    count.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+void EventBus::stop()
+{
+    int n = count.exchange(0);
+    for (int i = 0; i < n; ++i)
+    {
+        subscribers[i]->running.store(false, std::memory_order_release);
+        subscribers[i]->thread.join();
+        if (subscribers[i]->dropped > 0)
+            std::cerr << subscribers[i]->name << ": " << subscribers[i]->dropped << " events dropped" << std::endl;
+    }
+}
+
+void EventBus::publish(const GameEvent &event)
+{
+    int n = count.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i)
+    {
+        Subscriber &sub = *subscribers[i];
+        if (sub.queue.push(event))
+            continue;
+
+        sub.dropped.fetch_add(1, std::memory_order_relaxed);
+        if (sub.policy == OverflowPolicy::DROP_OLDEST)
+        {
+            // Make room, if the subscriber got there first the retry just succeeds
+            GameEvent oldest;
+            sub.queue.pop(oldest);
+            sub.queue.push(event);
+        }
+    }
+}
+
+unsigned long long EventBus::dropped(int subscriber) const
+{
+    return subscribers[subscriber] ? subscribers[subscriber]->dropped.load() : 0;
+}
+
+void emitEvent(GameEventType type, const Point &p, unsigned int value)
+{
+    if (!gameEvents.active())
+        return;
+
+    GameEvent event;
+    event.type = type;
+    event.tick = gameTick;
+    event.serial = gameSerial;
+    event.p = p;
+    event.dirX = snake.empty() ? DirectionX::NONE : snake.front().dirX;
+    event.dirY = snake.empty() ? DirectionY::NONE : snake.front().dirY;
+    event.value = value;
+    gameEvents.publish(event);
+}
+
+bool subscribeEventLog(const std::string &file, size_t capacity, const std::string &policy)
+{
+    std::shared_ptr<std::ofstream> out(new std::ofstream(file));
+    if (!*out)
+        return false;
+
+    OverflowPolicy overflow = policy == "drop-oldest" ? OverflowPolicy::DROP_OLDEST : OverflowPolicy::DROP_NEWEST;
+    return gameEvents.subscribe("log", capacity, overflow, [out](const GameEvent &e)
+    {
+        *out << "{\"event\":\"" << eventName(e.type) << "\",\"tick\":" << e.tick << ",\"game\":" << e.serial
+             << ",\"x\":" << e.p.x << ",\"y\":" << e.p.y
+             << ",\"dx\":" << static_cast<int>(e.dirX) << ",\"dy\":" << static_cast<int>(e.dirY)
+             << ",\"value\":" << e.value << "}\n";
+    });
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "snake.h"
+
+/**
+* Game events for telemetry, logging and the like.
+*
+* Every subscriber owns a bounded lock-free queue (Vyukov's MPMC ring) and a
+* thread that drains it. The game only ever does a few atomic operations per
+* event and never waits: when a queue is full the event is dropped, either
+* the new one or the oldest queued one, as the subscriber chose.
+*/
+enum class GameEventType : unsigned char {
+    APPLE_EATEN,
+    CRASH,
+    DIRECTION_CHANGE,
+    LEVEL_LOADED,
+};
+
+struct GameEvent {
+    GameEventType type;
+    unsigned int tick;
+    unsigned int serial;        // gameSerial of the thread that played it
+    Point p;                    // Apple, crash cell or head
+    DirectionX dirX;
+    DirectionY dirY;
+    unsigned int value;         // Apples eaten so far
+};
+
+const char* eventName(GameEventType type);
+
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    bool push(const T &item);
+    bool pop(T &item);
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    // Padding keeps producers and the consumer off each other's cache line,
+    // alignas() would need C++17 aligned new for heap allocated queues
+    char padBefore[64];
+    std::atomic<size_t> enqueuePos;
+    char padBetween[64];
+    std::atomic<size_t> dequeuePos;
+};
+
+enum class OverflowPolicy {
+    DROP_NEWEST,
+    DROP_OLDEST,
+};
+
+class EventBus {
+public:
+    typedef std::function<void(const GameEvent&)> Handler;
+
+    static const int MAX_SUBSCRIBERS = 8;
+
+    EventBus();
+    ~EventBus();
+
+    // Not thread-safe against publish(), subscribe before the games start
+    bool subscribe(const std::string &name, size_t capacity, OverflowPolicy policy, Handler handler);
+    void stop();        // Drains every queue, joins the subscriber threads and reports drops
+
+    bool active() const { return count.load(std::memory_order_acquire) > 0; }
+    void publish(const GameEvent &event);
+
+    unsigned long long dropped(int subscriber) const;
+
+private:
+    struct Subscriber;
+
+    std::unique_ptr<Subscriber> subscribers[MAX_SUBSCRIBERS];
+    std::atomic<int> count;
+};
+
+extern EventBus gameEvents;
+
+// Fills in tick and serial, does nothing without subscribers
+void emitEvent(GameEventType type, const Point &p, unsigned int value = 0);
+
+// "--events file [--events-queue N] [--events-policy drop-newest|drop-oldest]", JSON lines
+bool subscribeEventLog(const std::string &file, size_t capacity, const std::string &policy);
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity) : enqueuePos(0), dequeuePos(0)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool BoundedQueue<T>::push(const T &item)
+{
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = cells[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.data = item;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+            return false;   // Full
+        else
+            pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool BoundedQueue<T>::pop(T &item)
+{
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = cells[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0)
+        {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                item = cell.data;
+                cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+            return false;   // Empty
+        else
+            pos = dequeuePos.load(std::memory_order_relaxed);
+    }
+}
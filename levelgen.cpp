@@ -0,0 +1,216 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "levelgen.h"
+#include "levelpack.h"
+#include "snake.h"
+#include "tournament.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const int LEVEL_GEN_CELLS = LEVEL_GEN_WIDTH * LEVEL_GEN_HEIGHT;
+const int LEVEL_GEN_MAX_ATTEMPTS = 1000;
+
+// Where initSnake() puts the snake, plus room to move left
+const int SPAWN_X = (FIELD_SIZE_X - SNAKE_INIT_SIZE) / 2;
+const int SPAWN_Y = FIELD_SIZE_Y / 2;
+const int SPAWN_ROOM = 3;
+
+static uint64_t mixSeed(uint64_t x)
+{
+    // splitmix64 finalizer
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// A full 64 bit state for every candidate of every level
+static uint64_t mixSeed(uint64_t seed, uint64_t index, uint64_t attempt)
+{
+    return mixSeed(mixSeed(mixSeed(seed) ^ index) ^ attempt);
+}
+
+// Cheap to seed per candidate, unlike mt19937 with its 2.5 KB of state
+class LevelRandom {
+public:
+    typedef uint64_t result_type;
+
+    explicit LevelRandom(uint64_t seed) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~0ull; }
+    result_type operator()() { return mixSeed(state++); }
+
+private:
+    uint64_t state;
+};
+
+static void placeWalls(LevelRandom &engine, int walls, char* cells)
+{
+    for (int y = 0; y < LEVEL_GEN_HEIGHT; ++y)
+    {
+        for (int x = 0; x < LEVEL_GEN_WIDTH; ++x)
+        {
+            bool border = x == 0 || y == 0 || x == LEVEL_GEN_WIDTH - 1 || y == LEVEL_GEN_HEIGHT - 1;
+            cells[y * LEVEL_GEN_WIDTH + x] = border ? FIELD_CHAR_WALL : FIELD_CHAR_EMPTY;
+        }
+    }
+
+    std::uniform_int_distribution<int> xDist(1, LEVEL_GEN_WIDTH - 2);
+    std::uniform_int_distribution<int> yDist(1, LEVEL_GEN_HEIGHT - 2);
+    std::uniform_int_distribution<int> lengthDist(2, 8);
+    std::uniform_int_distribution<int> dirDist(0, 3);
+    const int dx[4] = { 1, -1, 0, 0 };
+    const int dy[4] = { 0, 0, 1, -1 };
+
+    // Straight segments, some of them bent once like the L in level2.txt
+    for (int i = 0; i < walls; ++i)
+    {
+        int x = xDist(engine), y = yDist(engine);
+        int dir = dirDist(engine);
+        int bends = dirDist(engine) == 0 ? 1 : 0;
+        for (int part = 0; part <= bends; ++part)
+        {
+            int length = lengthDist(engine);
+            for (int step = 0; step < length; ++step)
+            {
+                if (x < 1 || y < 1 || x > LEVEL_GEN_WIDTH - 2 || y > LEVEL_GEN_HEIGHT - 2)
+                    break;
+                cells[y * LEVEL_GEN_WIDTH + x] = FIELD_CHAR_WALL;
+                x += dx[dir];
+                y += dy[dir];
+            }
+            x -= dx[dir];
+            y -= dy[dir];
+            dir = dir < 2 ? 2 + (dirDist(engine) & 1) : dirDist(engine) & 1;
+        }
+    }
+}
+
+bool validateLevel(const char* cells)
+{
+    for (int x = SPAWN_X - SPAWN_ROOM; x < SPAWN_X + SNAKE_INIT_SIZE; ++x)
+    {
+        if (cells[SPAWN_Y * LEVEL_GEN_WIDTH + x] != FIELD_CHAR_EMPTY)
+            return false;
+    }
+
+    int freeCells = 0;
+    for (int i = 0; i < LEVEL_GEN_CELLS; ++i)
+        freeCells += cells[i] == FIELD_CHAR_EMPTY;
+
+    bool seen[LEVEL_GEN_CELLS] = {};
+    int stack[LEVEL_GEN_CELLS];
+    int top = 0;
+    int reached = 0;
+    stack[top++] = SPAWN_Y * LEVEL_GEN_WIDTH + SPAWN_X;
+    seen[stack[0]] = true;
+
+    // Borders are walls, so neighbours of a free cell never leave the level
+    const int offsets[4] = { 1, -1, LEVEL_GEN_WIDTH, -LEVEL_GEN_WIDTH };
+    while (top > 0)
+    {
+        int cell = stack[--top];
+        reached++;
+        for (int offset : offsets)
+        {
+            int next = cell + offset;
+            if (!seen[next] && cells[next] == FIELD_CHAR_EMPTY)
+            {
+                seen[next] = true;
+                stack[top++] = next;
+            }
+        }
+    }
+    return reached == freeCells;
+}
+
+bool generateLevel(uint64_t seed, uint64_t index, int walls, char* cells, unsigned int &rejected)
+{
+    // Every level gets its own stream, so the pack doesn't depend on the thread count
+    rejected = 0;
+    for (int attempt = 0; attempt < LEVEL_GEN_MAX_ATTEMPTS; ++attempt)
+    {
+        LevelRandom engine(mixSeed(seed, index, static_cast<uint64_t>(attempt)));
+
+        placeWalls(engine, walls, cells);
+        if (validateLevel(cells))
+            return true;
+        rejected++;
+    }
+    return false;
+}
+
+int runLevelGenerator(const Args &args)
+{
+    long count = args.intValue("--generate-levels", 0);
+    std::string out = args.value("--out", "");
+    if (count <= 0 || out.empty())
+    {
+        std::cerr << "Usage: --generate-levels N --out file.pack [--seed N] [--threads N] [--walls N]" << std::endl;
+        return 1;
+    }
+
+    uint64_t seed = static_cast<uint64_t>(args.intValue("--seed", 1));
+    int walls = static_cast<int>(args.intValue("--walls", 6));
+    unsigned int threads = threadCount(args);
+
+    std::vector<char> cells(static_cast<size_t>(count) * LEVEL_GEN_CELLS);
+    std::atomic<size_t> next(0);
+    std::atomic<unsigned long long> rejected(0);
+    std::atomic<unsigned long long> failed(0);
+
+    // Small batches keep the shared counter out of the hot loop
+    const size_t batch = 256;
+    Clock::time_point start = Clock::now();
+
+    auto worker = [&]()
+    {
+        unsigned long long localRejected = 0, localFailed = 0;
+        for (size_t first = next.fetch_add(batch); first < static_cast<size_t>(count); first = next.fetch_add(batch))
+        {
+            size_t last = std::min(first + batch, static_cast<size_t>(count));
+            for (size_t i = first; i < last; ++i)
+            {
+                unsigned int levelRejected = 0;
+                if (!generateLevel(seed, i, walls, cells.data() + i * LEVEL_GEN_CELLS, levelRejected))
+                    localFailed++;
+                localRejected += levelRejected;
+            }
+        }
+        rejected += localRejected;
+        failed += localFailed;
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; ++i)
+        pool.push_back(std::thread(worker));
+    for (auto &thread : pool)
+        thread.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    unsigned long long candidates = static_cast<unsigned long long>(count) - failed + rejected;
+
+    std::cout << count - failed << " levels from " << candidates << " candidates on " << threads << " threads in "
+              << seconds << " s, " << static_cast<unsigned long long>(candidates / (seconds > 0 ? seconds : 1))
+              << " candidates/s" << std::endl;
+
+    // A pack padded out with placeholder levels would pass for what was asked
+    if (failed > 0)
+    {
+        std::cerr << failed << " of " << count << " levels had no valid layout with " << walls << " walls in "
+                  << LEVEL_GEN_MAX_ATTEMPTS << " candidates, nothing written, try fewer --walls" << std::endl;
+        return 1;
+    }
+
+    if (!writeLevelPack(out, LEVEL_GEN_WIDTH, LEVEL_GEN_HEIGHT, cells))
+    {
+        std::cerr << "Can't write level pack: " << out << std::endl;
+        return 1;
+    }
+    return 0;
+}
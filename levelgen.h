@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include "args.h"
+#include "snake.h"
+
+/**
+* Procedural levels like level2.txt: a border plus random wall segments.
+* A candidate is kept only if all free cells are connected and the snake's
+* spawn row is free, rejected candidates are retried with the next attempt seed.
+* Levels are generated in parallel and written into a level pack. A level that
+* finds no valid layout fails the run rather than going in empty.
+*
+*   --generate-levels N --out file.pack [--seed N] [--threads N] [--walls N]
+*/
+const int LEVEL_GEN_WIDTH = FIELD_SIZE_X - 1;     // Without the '\0' column
+const int LEVEL_GEN_HEIGHT = FIELD_SIZE_Y;
+
+// Fills cells (width * height) with level number index, false if every candidate was rejected
+bool generateLevel(uint64_t seed, uint64_t index, int walls, char* cells, unsigned int &rejected);
+
+// Flood fill check of a generated level
+bool validateLevel(const char* cells);
+
+int runLevelGenerator(const Args &args);
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include "levelpack.h"
+#include "spawn.h"
+#include "tournament.h"
+
+const char PACK_MAGIC[8] = { 'S', 'N', 'K', 'P', 'A', 'C', 'K', '1' };
+const size_t PACK_HEADER_SIZE = 16;
+const size_t PACK_ENTRY_SIZE = 12;
+
+static uint32_t readU32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint16_t readU16(const unsigned char* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static void putU32(std::string &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+static void putU16(std::string &out, uint32_t value)
+{
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>((value >> 8) & 0xFF);
+}
+
+uint32_t levelChecksum(const char* cells, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(cells[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool LevelPack::open(const std::string &name)
+{
+    levelCount = 0;
+    if (!file.open(name))
+        return false;
+
+    const unsigned char* data = file.data();
+    if (file.size() < PACK_HEADER_SIZE || std::string(reinterpret_cast<const char*>(data), 8) != std::string(PACK_MAGIC, 8))
+        return false;
+
+    uint32_t count = readU32(data + 8);
+    if ((file.size() - PACK_HEADER_SIZE) / PACK_ENTRY_SIZE < count)
+        return false;
+
+    // Validate the table once, so level() can trust it
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const unsigned char* entry = data + PACK_HEADER_SIZE + i * PACK_ENTRY_SIZE;
+        uint64_t width = readU16(entry + 4), height = readU16(entry + 6);
+        uint64_t end = readU32(entry) + width * height;
+        if (width == 0 || height == 0 || end > file.size())
+            return false;
+    }
+
+    levelCount = count;
+    return true;
+}
+
+LevelView LevelPack::level(uint32_t index) const
+{
+    const unsigned char* entry = file.data() + PACK_HEADER_SIZE + index * PACK_ENTRY_SIZE;
+    LevelView view;
+    view.cells = reinterpret_cast<const char*>(file.data() + readU32(entry));
+    view.width = readU16(entry + 4);
+    view.height = readU16(entry + 6);
+    view.checksum = readU32(entry + 8);
+    return view;
+}
+
+bool LevelPack::verify(uint32_t index) const
+{
+    LevelView view = level(index);
+    return levelChecksum(view.cells, static_cast<size_t>(view.width) * view.height) == view.checksum;
+}
+
+bool readLevelText(const std::string &file, PackLevel &level)
+{
+    std::ifstream in(file);
+    if (!in)
+        return false;
+
+    std::vector<std::string> rows;
+    std::string line;
+    size_t width = 0;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+        rows.push_back(line);
+        width = std::max(width, line.size());
+    }
+    if (rows.empty() || width > 0xFFFF || rows.size() > 0xFFFF)
+        return false;
+
+    level.width = static_cast<int>(width);
+    level.height = static_cast<int>(rows.size());
+    level.cells.clear();
+    for (auto &row : rows)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            // Past the end of a short row is a wall, as readLevel() has it
+            char ch = x < row.size() ? row[x] : FIELD_CHAR_WALL;
+            level.cells += ch == FIELD_CHAR_WALL || spawnWeight(ch) >= 0 ? ch : FIELD_CHAR_EMPTY;
+        }
+    }
+    return true;
+}
+
+static std::string packHeader(uint32_t count)
+{
+    std::string out(PACK_MAGIC, sizeof(PACK_MAGIC));
+    putU32(out, count);
+    putU32(out, 0);
+    return out;
+}
+
+static bool putEntry(std::string &out, uint64_t offset, int width, int height, const char* cells)
+{
+    if (offset + static_cast<uint64_t>(width) * height > 0xFFFFFFFFu)
+        return false;
+    putU32(out, static_cast<uint32_t>(offset));
+    putU16(out, width);
+    putU16(out, height);
+    putU32(out, levelChecksum(cells, static_cast<size_t>(width) * height));
+    return true;
+}
+
+bool writeLevelPack(const std::string &file, const std::vector<PackLevel> &levels)
+{
+    std::string out = packHeader(static_cast<uint32_t>(levels.size()));
+
+    uint64_t offset = PACK_HEADER_SIZE + levels.size() * PACK_ENTRY_SIZE;
+    for (auto &level : levels)
+    {
+        if (!putEntry(out, offset, level.width, level.height, level.cells.data()))
+            return false;
+        offset += level.cells.size();
+    }
+    for (auto &level : levels)
+        out += level.cells;
+
+    std::ofstream stream(file, std::ios::binary);
+    stream.write(out.data(), out.size());
+    return static_cast<bool>(stream);
+}
+
+bool writeLevelPack(const std::string &file, int width, int height, const std::vector<char> &cells)
+{
+    size_t levelSize = static_cast<size_t>(width) * height;
+    size_t count = cells.size() / levelSize;
+    std::string table = packHeader(static_cast<uint32_t>(count));
+    table.reserve(PACK_HEADER_SIZE + count * PACK_ENTRY_SIZE);
+
+    uint64_t offset = PACK_HEADER_SIZE + count * PACK_ENTRY_SIZE;
+    for (size_t i = 0; i < count; ++i, offset += levelSize)
+    {
+        if (!putEntry(table, offset, width, height, cells.data() + i * levelSize))
+            return false;
+    }
+
+    std::ofstream stream(file, std::ios::binary);
+    stream.write(table.data(), table.size());
+    stream.write(cells.data(), count * levelSize);
+    return static_cast<bool>(stream);
+}
+
+bool levelToField(const LevelView &level, GameFieldArray &field)
+{
+    if (level.width < 1 || level.height < 1 || level.width > FIELD_SIZE_X - 1 || level.height > FIELD_SIZE_Y)
+        return false;
+
+    // Everything outside of the level is a wall
+    for (auto &row : field)
+    {
+        row.fill(FIELD_CHAR_WALL);
+        row[FIELD_SIZE_X - 1] = '\0';
+    }
+
+    for (int y = 0; y < level.height; ++y)
+    {
+        for (int x = 0; x < level.width; ++x)
+        {
+            char ch = level.cells[y * level.width + x];
+            field[y][x] = ch == FIELD_CHAR_WALL || spawnWeight(ch) >= 0 ? ch : FIELD_CHAR_EMPTY;
+        }
+    }
+    return isLevelClosed(field);
+}
+
+int runLevelPackTool(const Args &args)
+{
+    if (args.has("--pack-info"))
+    {
+        LevelPack pack;
+        if (!pack.open(args.value("--pack-info", "")))
+        {
+            std::cerr << "Can't open level pack: " << args.value("--pack-info", "") << std::endl;
+            return 1;
+        }
+
+        uint32_t broken = 0;
+        for (uint32_t i = 0; i < pack.count(); ++i)
+        {
+            if (!pack.verify(i))
+            {
+                std::cout << "Level " << i << ": bad checksum" << std::endl;
+                broken++;
+            }
+        }
+        std::cout << pack.count() << " levels, " << broken << " broken" << std::endl;
+        return broken == 0 ? 0 : 1;
+    }
+
+    std::vector<PackLevel> levels;
+    for (auto &name : splitList(args.value("--levels", "")))
+    {
+        PackLevel level;
+        if (!readLevelText(name, level))
+        {
+            std::cerr << "Can't load level: " << name << std::endl;
+            return 1;
+        }
+        levels.push_back(level);
+    }
+
+    if (!writeLevelPack(args.value("--pack-levels", ""), levels))
+    {
+        std::cerr << "Can't write level pack: " << args.value("--pack-levels", "") << std::endl;
+        return 1;
+    }
+    std::cout << levels.size() << " levels packed" << std::endl;
+    return 0;
+}
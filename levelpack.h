@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "args.h"
+#include "mappedfile.h"
+#include "snake.h"
+
+/**
+* Many levels in one memory mapped file.
+*
+* Little-endian layout:
+*   header: "SNKPACK1", u32 level count, u32 reserved
+*   offset table, per level: u32 offset, u16 width, u16 height, u32 FNV-1a checksum of cells
+*   level cells: width * height chars per level, rows without line ends,
+*   "#" for walls, digits for apple spawn weights (see spawn.h), " " otherwise
+*
+* Any level is found through the offset table in O(1)
+* and read straight from the mapping.
+*/
+struct LevelView {
+    const char* cells;
+    int width;
+    int height;
+    uint32_t checksum;
+};
+
+struct PackLevel {
+    int width;
+    int height;
+    std::string cells;
+};
+
+class LevelPack {
+public:
+    bool open(const std::string &file);
+
+    uint32_t count() const { return levelCount; }
+    LevelView level(uint32_t index) const;
+    bool verify(uint32_t index) const;      // Recomputes the checksum
+
+private:
+    MappedFile file;
+    uint32_t levelCount;
+};
+
+uint32_t levelChecksum(const char* cells, size_t size);
+
+bool readLevelText(const std::string &file, PackLevel &level);
+bool writeLevelPack(const std::string &file, const std::vector<PackLevel> &levels);
+// Levels of one size stored back to back in cells
+bool writeLevelPack(const std::string &file, int width, int height, const std::vector<char> &cells);
+
+// Copies a packed level into a game field, false if it doesn't fit or isn't walled in
+bool levelToField(const LevelView &level, GameFieldArray &field);
+
+// "--pack-levels out.pack --levels a.txt,b.txt" and "--pack-info file"
+int runLevelPackTool(const Args &args);
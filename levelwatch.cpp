@@ -0,0 +1,143 @@
+#include <chrono>
+#include <sys/stat.h>
+#include "distfield.h"
+#include "levelwatch.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+const int WATCH_POLL_MS = 250;
+
+LevelWatcher::LevelWatcher() : running(false), pending(nullptr)
+{
+}
+
+LevelWatcher::~LevelWatcher()
+{
+    stop();
+}
+
+bool LevelWatcher::start(const std::string &file)
+{
+    stop();
+
+    levelFile = file;
+    watchedFile = file;
+    std::string::size_type colon = file.rfind(':');
+    if (colon != std::string::npos && colon + 1 < file.size()
+        && file.find_first_not_of("0123456789", colon + 1) == std::string::npos)
+    {
+        watchedFile = file.substr(0, colon);
+    }
+
+    struct stat info;
+    if (stat(watchedFile.c_str(), &info) != 0)
+        return false;
+
+    running = true;
+    thread = std::thread(&LevelWatcher::run, this);
+    return true;
+}
+
+void LevelWatcher::stop()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+    delete pending.exchange(nullptr);
+}
+
+std::unique_ptr<GameFieldArray> LevelWatcher::take()
+{
+    return std::unique_ptr<GameFieldArray>(pending.exchange(nullptr));
+}
+
+void LevelWatcher::publish(GameFieldArray* level)
+{
+    // A level the game hasn't picked up yet is out of date now
+    delete pending.exchange(level);
+}
+
+void LevelWatcher::reload()
+{
+    std::unique_ptr<GameFieldArray> level(new GameFieldArray());
+    if (!readLevel(levelFile, *level))
+        return;     // Half written file, the next change event brings the rest
+
+    // Build the distance map here, so the game loop finds it in the cache
+    distanceFieldFor(*level);
+    publish(level.release());
+}
+
+#ifdef __linux__
+
+void LevelWatcher::run()
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    // Watch the directory, editors often save by renaming a new file over the old one
+    std::string::size_type slash = watchedFile.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : watchedFile.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? watchedFile : watchedFile.substr(slash + 1);
+
+    if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    while (running)
+    {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, WATCH_POLL_MS) <= 0)
+            continue;
+
+        bool changed = false;
+        ssize_t size;
+        while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* p = buffer; p < buffer + size; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0 && name == event->name)
+                    changed = true;
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (changed)
+            reload();
+    }
+    close(fd);
+}
+
+#else
+
+void LevelWatcher::run()
+{
+    struct stat last;
+    bool known = stat(watchedFile.c_str(), &last) == 0;
+
+    while (running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_POLL_MS));
+
+        struct stat info;
+        if (stat(watchedFile.c_str(), &info) != 0)
+            continue;
+
+        if (!known || info.st_mtime != last.st_mtime || info.st_size != last.st_size)
+        {
+            last = info;
+            known = true;
+            reload();
+        }
+    }
+}
+
+#endif
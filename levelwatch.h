@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "snake.h"
+
+/**
+* Watches a level file and reparses it on a background thread whenever it changes.
+* Uses inotify on Linux and polls the file's mtime elsewhere.
+*
+* The parsed level is handed over through an atomic pointer: the watcher exchanges
+* in the new level, the game loop exchanges it out with take() between ticks,
+* so neither side ever waits for the other.
+*/
+class LevelWatcher {
+public:
+    LevelWatcher();
+    ~LevelWatcher();
+
+    bool start(const std::string &levelFile);
+    void stop();
+
+    // Latest reparsed level or an empty pointer, never blocks
+    std::unique_ptr<GameFieldArray> take();
+
+private:
+    void run();
+    void reload();
+    void publish(GameFieldArray* level);
+
+    std::string levelFile;
+    std::string watchedFile;    // levelFile without a ":N" level pack index
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<GameFieldArray*> pending;
+};
@@ -0,0 +1,332 @@
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "lockstep.h"
+#include "apples.h"
+#include "board.h"
+#include "process.h"
+#include "tournament.h"
+
+// The game in snake.h, snake kept in a std::list
+class ListEngine : public LockstepEngine {
+public:
+    ListEngine() : bot(nullptr), maxTicks(0), crashed(false) {}
+
+    bool start(const LockstepGame &game) override
+    {
+        bot = game.bot;
+        maxTicks = game.maxTicks;
+        crashed = false;
+
+        appleTarget = game.apples;
+        initGame(game.seed);
+        if (!game.level.empty())
+        {
+            GameFieldArray level;
+            if (!readLevel(game.level, level))
+                return false;
+            initLevel(level);
+        }
+        return true;
+    }
+
+    bool step() override
+    {
+        if (crashed || gameTick >= maxTicks)
+            return false;
+        bot->decide();
+        crashed = !stepGame();
+        return true;
+    }
+
+    unsigned int tick() const override { return gameTick; }
+
+    std::string describe() const override
+    {
+        return describeState(gameTick, applesEaten, crashed, gameField, snake);
+    }
+
+private:
+    const BotInfo* bot;
+    unsigned int maxTicks;
+    bool crashed;
+};
+
+// The same rules on a Board, fixed size specialization or forced dynamic
+class BoardLockstepEngine : public LockstepEngine {
+public:
+    explicit BoardLockstepEngine(bool dynamicOnly)
+        : board(createBoardEngine(FIELD_SIZE_X - 1, FIELD_SIZE_Y, dynamicOnly)), bot(BoardBot::STRAIGHT), maxTicks(0) {}
+
+    bool start(const LockstepGame &game) override
+    {
+        if (!findBoardBot(game.bot->name, bot))
+        {
+            std::cerr << "Board engines only play straight, random and greedy" << std::endl;
+            return false;
+        }
+        maxTicks = game.maxTicks;
+
+        board->start(game.seed, game.apples);
+        if (!game.level.empty())
+        {
+            GameFieldArray level;
+            if (!readLevel(game.level, level) || !board->loadLevel(level))
+                return false;
+        }
+        return true;
+    }
+
+    bool step() override
+    {
+        if (board->crashed() || board->tick() >= maxTicks)
+            return false;
+        board->step(bot);
+        return true;
+    }
+
+    unsigned int tick() const override { return board->tick(); }
+
+    std::string describe() const override
+    {
+        GameFieldArray field;
+        Snake snake;
+        board->toGame(field, snake);
+        return describeState(board->tick(), board->applesEaten(), board->crashed(), field, snake);
+    }
+
+private:
+    std::unique_ptr<BoardEngine> board;
+    BoardBot bot;
+    unsigned int maxTicks;
+};
+
+std::unique_ptr<LockstepEngine> createLockstepEngine(const std::string &name)
+{
+    if (name == "list")
+        return std::unique_ptr<LockstepEngine>(new ListEngine());
+    if (name == "board")
+        return std::unique_ptr<LockstepEngine>(new BoardLockstepEngine(false));
+    if (name == "board-dynamic")
+        return std::unique_ptr<LockstepEngine>(new BoardLockstepEngine(true));
+    return std::unique_ptr<LockstepEngine>();
+}
+
+std::string describeState(unsigned int tick, unsigned int applesEaten, bool crashed,
+                          const GameFieldArray &field, const Snake &snake)
+{
+    std::ostringstream out;
+    out << "tick " << tick << "\n";
+    out << "apples eaten " << applesEaten << "\n";
+    out << "crashed " << (crashed ? 1 : 0) << "\n";
+
+    out << "snake";
+    for (auto &segm : snake)
+        out << " " << segm.x << "," << segm.y;
+    out << "\n";
+    out << "heading " << static_cast<int>(snake.front().dirX) << "," << static_cast<int>(snake.front().dirY) << "\n";
+
+    GameFieldArray picture = field;
+    for (auto &segm : snake)
+        picture[segm.y][segm.x] = FIELD_CHAR_SNAKE;
+    for (auto &row : picture)
+        out << row.data() << "\n";
+    return out.str();
+}
+
+static uint64_t checksum(const std::string &text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char ch : text)
+    {
+        hash ^= ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int runLockstepChild(const Args &args)
+{
+    std::unique_ptr<LockstepEngine> engine = createLockstepEngine(args.value("--engine", "list"));
+    if (!engine)
+    {
+        std::cerr << "Unknown engine: " << args.value("--engine", "list") << std::endl;
+        return 1;
+    }
+
+    LockstepGame game;
+    game.seed = static_cast<unsigned int>(args.intValue("--seed", 1));
+    game.maxTicks = static_cast<unsigned int>(args.intValue("--max-ticks", 10000));
+    game.apples = static_cast<unsigned int>(args.intValue("--apples", 1));
+    game.level = args.value("--level", "");
+    game.bot = findBot(args.value("--bot", "greedy"));
+    if (!game.bot || !engine->start(game))
+    {
+        std::cerr << "Can't start lockstep game" << std::endl;
+        return 1;
+    }
+
+    // Tick 0 is checked too, before any move
+    do
+    {
+        std::string state = engine->describe();
+        printf("%u %016llx\n", engine->tick(), static_cast<unsigned long long>(checksum(state)));
+        fflush(stdout);
+
+        int reply = getchar();
+        if (reply == 'd')
+        {
+            fputs(state.c_str(), stdout);
+            puts("end");
+            fflush(stdout);
+            return 0;
+        }
+        if (reply != 'c')
+            return 0;
+    } while (engine->step());
+
+    printf("done %u\n", engine->tick());
+    fflush(stdout);
+    return 0;
+}
+
+// Lines from a child's stdout
+class LineReader {
+public:
+    explicit LineReader(ChildProcess &child) : child(child) {}
+
+    bool next(std::string &line)
+    {
+        for (;;)
+        {
+            std::string::size_type end = buffer.find('\n');
+            if (end != std::string::npos)
+            {
+                line = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+
+            char chunk[4096];
+            long size = child.readSome(chunk, sizeof(chunk));
+            if (size <= 0)
+                return false;
+            buffer.append(chunk, static_cast<size_t>(size));
+        }
+    }
+
+private:
+    ChildProcess &child;
+    std::string buffer;
+};
+
+static std::string quote(const std::string &arg)
+{
+    std::string out = "'";
+    for (char ch : arg)
+        out += ch == '\'' ? std::string("'\\''") : std::string(1, ch);
+    return out + "'";
+}
+
+static std::vector<std::string> dumpState(ChildProcess &child, LineReader &reader)
+{
+    std::vector<std::string> lines;
+    child.writeAll("d", 1);
+    std::string line;
+    while (reader.next(line) && line != "end")
+        lines.push_back(line);
+    return lines;
+}
+
+static void printDiff(const std::vector<std::string> &a, const std::vector<std::string> &b)
+{
+    for (size_t i = 0; i < a.size() || i < b.size(); ++i)
+    {
+        const std::string left = i < a.size() ? a[i] : "";
+        const std::string right = i < b.size() ? b[i] : "";
+        std::cout << (left == right ? "    " : "  ! ") << left;
+        if (left != right)
+            std::cout << "  |  " << right;
+        std::cout << std::endl;
+    }
+}
+
+int runLockstep(const Args &args)
+{
+    std::string self = quote(args.program());
+    std::string buildA = args.value("--build-a", self.c_str());
+    std::string buildB = args.value("--build-b", self.c_str());
+
+    std::string common = " --lockstep-child --bot " + quote(args.value("--bot", "greedy"))
+                       + " --max-ticks " + std::to_string(args.intValue("--max-ticks", 10000))
+                       + " --apples " + std::to_string(args.intValue("--apples", 1));
+    if (args.has("--level"))
+        common += " --level " + quote(args.value("--level", ""));
+
+    std::string sideA = buildA + common + " --engine " + quote(args.value("--engine-a", "list"));
+    std::string sideB = buildB + common + " --engine " + quote(args.value("--engine-b", "list"));
+
+    unsigned int seeds = static_cast<unsigned int>(args.intValue("--seeds", 10));
+    unsigned long long ticks = 0;
+    unsigned int diverged = 0;
+
+    for (unsigned int seed = 1; seed <= seeds; ++seed)
+    {
+        std::string seedArg = " --seed " + std::to_string(seed);
+        ChildProcess a, b;
+        if (!a.start((sideA + seedArg).c_str()) || !b.start((sideB + seedArg).c_str()))
+        {
+            std::cerr << "Can't start lockstep children" << std::endl;
+            return 1;
+        }
+
+        LineReader readA(a), readB(b);
+        std::string lineA, lineB;
+        for (;;)
+        {
+            bool hasA = readA.next(lineA), hasB = readB.next(lineB);
+            if (!hasA || !hasB)
+            {
+                std::cout << "Seed " << seed << ": " << (hasA ? "B" : "A") << " stopped without finishing the game" << std::endl;
+                diverged++;
+                break;
+            }
+
+            if (lineA != lineB)
+            {
+                // "<tick> <checksum>" while a game runs, "done <tick>" once it has ended
+                const bool doneA = lineA.compare(0, 5, "done ") == 0, doneB = lineB.compare(0, 5, "done ") == 0;
+                std::string tickA = doneA ? lineA.substr(5) : lineA.substr(0, lineA.find(' '));
+                std::string tickB = doneB ? lineB.substr(5) : lineB.substr(0, lineB.find(' '));
+
+                std::cout << "Seed " << seed << ": ";
+                if (doneA != doneB)
+                    std::cout << (doneA ? "A" : "B") << " ended the game at tick " << (doneA ? tickA : tickB)
+                              << ", " << (doneA ? "B" : "A") << " played on" << std::endl;
+                else if (doneA)
+                    std::cout << "games ended at tick " << tickA << " (A) / " << tickB << " (B)" << std::endl;
+                else
+                    std::cout << "first divergence at tick " << (tickA == tickB ? tickA : tickA + " (A) / " + tickB + " (B)") << std::endl;
+
+                if (!doneA && !doneB)
+                    printDiff(dumpState(a, readA), dumpState(b, readB));
+                diverged++;
+                break;
+            }
+            if (lineA.compare(0, 4, "done") == 0)
+                break;
+
+            ticks++;
+            a.writeAll("c", 1);
+            b.writeAll("c", 1);
+        }
+
+        a.wait();
+        b.wait();
+    }
+
+    std::cout << seeds << " games, " << ticks << " ticks compared, "
+              << (diverged ? std::to_string(diverged) + " diverged" : std::string("all identical")) << std::endl;
+    return diverged ? 1 : 0;
+}
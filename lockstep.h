@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "args.h"
+#include "bots.h"
+
+/**
+* Lockstep determinism check: two builds or two engine variants play the same
+* seeded games side by side and compare a state checksum after every tick.
+* The first tick where they disagree is reported with a diff of both states.
+*
+*   --lockstep [--build-a cmd] [--build-b cmd] [--engine-a name] [--engine-b name]
+*   [--seeds N] [--bot name] [--level file] [--apples N] [--max-ticks N]
+*
+* Engines are "list" (the game itself), "board" and "board-dynamic" (see
+* board.h, straight, random and greedy bots only).
+*
+* Builds are shell commands, both default to this binary. Each game runs one
+* "--lockstep-child" process per side. After every tick a child writes
+* "<tick> <checksum>\n" and waits for a byte: 'c' to go on, 'd' to dump its
+* state and quit. A finished game is reported as "done <tick>\n".
+*/
+struct LockstepGame {
+    unsigned int seed;
+    unsigned int maxTicks;
+    unsigned int apples;
+    std::string level;
+    const BotInfo* bot;
+};
+
+// One way to run the game rules, picked with --engine
+class LockstepEngine {
+public:
+    virtual ~LockstepEngine() {}
+
+    virtual bool start(const LockstepGame &game) = 0;
+    virtual bool step() = 0;                    // False once the game is over
+    virtual unsigned int tick() const = 0;
+    virtual std::string describe() const = 0;   // Canonical state text, see describeState()
+};
+
+std::unique_ptr<LockstepEngine> createLockstepEngine(const std::string &name);
+
+// Text every engine must produce for the same state, the checksum is taken over it
+std::string describeState(unsigned int tick, unsigned int applesEaten, bool crashed,
+                          const GameFieldArray &field, const Snake &snake);
+
+int runLockstepChild(const Args &args);
+int runLockstep(const Args &args);
@@ -7,48 +7,79 @@
 * '@' - apple
 */
 
-#ifdef _WIN32
-#define PDC_DLL_BUILD
-#include "curses.h"
-#else
-#include <ncurses.h>
-#endif
 #include <array>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <list>
+#include <random>
+#include <ctime>
+#include <cerrno>
+#include <cstdlib>
 #include "snake.h"
-
-const int FIELD_SIZE_X = 20;
-const int FIELD_SIZE_Y = 15;
-const int SNAKE_INIT_SIZE = 6;
-
-const char FIELD_CHAR_WALL = '#';
-const char FIELD_CHAR_APPLE = '@';
-const char FIELD_CHAR_SNAKE = '*';
-const char FIELD_CHAR_EMPTY = ' ';
-
-typedef std::array<std::array<char, FIELD_SIZE_X>, FIELD_SIZE_Y> GameFieldArray;
-typedef std::list<SnakeSegment> Snake;
-
-GameFieldArray gameField;
-Snake snake;
-bool exitGame = false;
-
-void init();
-void initCurses();
+#include "args.h"
+#include "botpipe.h"
+#include "bots.h"
+#include "tournament.h"
+#include "trainer.h"
+#include "mlp.h"
+#include "distfield.h"
+#include "renderer.h"
+#include "recorder.h"
+#include "rasterizer.h"
+#include "levelpack.h"
+#include "levelgen.h"
+#include "levelwatch.h"
+#include "ticker.h"
+#include "scores.h"
+#include "apples.h"
+#include "spawn.h"
+#include "rewind.h"
+#include "lockstep.h"
+#include "events.h"
+#include "metrics.h"
+#include "trace.h"
+#include "board.h"
+#include "bitboard.h"
+
+thread_local GameFieldArray gameField;
+thread_local Snake snake;
+thread_local bool exitGame = false;
+thread_local FieldChanges fieldChanges;
+thread_local unsigned int gameTick = 0;
+thread_local unsigned int applesEaten = 0;
+thread_local unsigned int gameSerial = 0;
+thread_local AppleIndex apples;
+thread_local unsigned int appleTarget = 1;
+thread_local AppleSpawner appleSpawner;
+thread_local RewindBuffer* rewindBuffer = nullptr;
+thread_local FieldBits snakeCells;
+
+const unsigned int REWIND_KEY_TICKS = 10;
+
+thread_local std::mt19937 randomEngine;
+thread_local unsigned long long randomDraws = 0;
+
+std::unique_ptr<Renderer> renderer;
+std::unique_ptr<GameRecorder> recorder;
+BotPipe botPipe;
+const BotInfo* localBot = nullptr;
+LevelWatcher levelWatcher;
+TickScheduler scheduler;
+
+bool init(const std::string &rendererName);
 void initField();
 void initSnake();
 
 void update();
+void playTick();
 
-void endCurses();
+void shutdown();
 
 void drawField();
 
 char getFieldChar(const Point &p) { return gameField[p.y][p.x]; };
-void setFieldChar(const Point &p, const char value) { gameField[p.y][p.x] = value; };
+void setFieldChar(const Point &p, const char value) { gameField[p.y][p.x] = value; fieldChanges.push_back(FieldChange(p, value)); };
 void setFieldChar(const int x, const int y, const char value) { gameField[y][x] = value; };
 
 bool isWall(const Point &p) { return getFieldChar(p) == FIELD_CHAR_WALL; }
@@ -58,68 +89,456 @@ bool isApple(const Point &p) { return getFieldChar(p) == FIELD_CHAR_APPLE; }
 bool checkFieldCrash();
 bool checkSelfCrash();
 
-bool moveSnake();
 SnakeSegment getNextMove();
 
-void setSnakeDirection(DirectionX dirX, DirectionY dirY);
-
-void addApple();
-unsigned int random(unsigned int min, unsigned int max);
+bool addApple();
+void spawnApples();
 
-void drawString(const int x, const int y, const char* str) { mvprintw(y, x, str); };
-void drawChar(const int x, const int y, const char ch) { mvaddch(y, x, ch); };
+void drawString(const int x, const int y, const char* str) { renderer->drawString(x, y, str); };
+void drawChar(const int x, const int y, const char ch) { renderer->drawChar(x, y, ch); };
 
 void drawMessage(const char* str) { drawString(5, FIELD_SIZE_Y + 2, str); }
 
 void reactToInput(int key);
-bool checkCrash();
-void loadLevel(std::string levelFile);
+void reactToBot();
+bool loadLevel(const std::string &levelFile);
 
-int main()
+int main(int argc, char* argv[])
 {
-    init();
+    Args args(argc, argv);
+
+    if (args.has("--weights"))
+    {
+        if (!loadBotWeights(args.value("--weights", ""), defaultBotWeights))
+        {
+            std::cerr << "Can't load bot weights: " << args.value("--weights", "") << std::endl;
+            return 1;
+        }
+        botWeights = defaultBotWeights;
+    }
+
+    if (args.has("--events") && !subscribeEventLog(args.value("--events", ""),
+                                                   static_cast<size_t>(args.intValue("--events-queue", 4096)),
+                                                   args.value("--events-policy", "drop-newest")))
+    {
+        std::cerr << "Can't write events: " << args.value("--events", "") << std::endl;
+        return 1;
+    }
+
+    if (args.has("--metrics") && !metricsExporter.start(args.value("--metrics", ""),
+                                                        static_cast<unsigned int>(args.intValue("--metrics-interval", 1000))))
+    {
+        std::cerr << "Can't export metrics: " << args.value("--metrics", "") << std::endl;
+        return 1;
+    }
+
+    if (args.has("--trace") && !tracer.start(args.value("--trace", ""),
+                                             static_cast<size_t>(args.intValue("--trace-buffer", 65536))))
+    {
+        std::cerr << "Can't write trace: " << args.value("--trace", "") << std::endl;
+        return 1;
+    }
+
+    distanceCacheDir = args.value("--dist-cache", "");
+    distanceThreads = threadCount(args);
+
+    if (args.has("--mlp-init"))
+    {
+        policyNet.randomize(static_cast<int>(args.intValue("--mlp-hidden", 32)), static_cast<unsigned int>(args.intValue("--seed", 1)));
+        return policyNet.save(args.value("--mlp-init", "")) ? 0 : 1;
+    }
+
+    if (args.has("--mlp") && !policyNet.load(args.value("--mlp", "")))
+    {
+        std::cerr << "Can't load policy network: " << args.value("--mlp", "") << std::endl;
+        return 1;
+    }
+
+    if (args.has("--train"))
+        return runTrainer(args);
+
+    if (args.has("--tournament"))
+        return runTournament(args);
+
+    if (args.has("--play"))
+        return runPlayer(args);
+
+    if (args.has("--rasterize"))
+        return runRasterizer(args);
+
+    if (args.has("--pack-levels") || args.has("--pack-info"))
+        return runLevelPackTool(args);
 
-    refresh();
+    if (args.has("--lockstep-child"))
+        return runLockstepChild(args);
+
+    if (args.has("--lockstep"))
+        return runLockstep(args);
+
+    if (args.has("--top") || args.has("--reindex"))
+        return runScoreQuery(args);
+
+    if (args.has("--bench-board"))
+        return runBoardBenchmark(args);
+
+    if (args.has("--generate-levels"))
+        return runLevelGenerator(args);
+
+    if (args.has("--bot"))
+    {
+        localBot = findBot(args.value("--bot", ""));
+        if (!localBot)
+        {
+            std::cerr << "Unknown bot: " << args.value("--bot", "") << std::endl;
+            return 1;
+        }
+    }
+
+    appleTarget = static_cast<unsigned int>(args.intValue("--apples", 1));
+    initGame(static_cast<unsigned int>(args.intValue("--seed", 1)));
+
+    if (args.has("--level") && !loadLevel(args.value("--level", "")))
+    {
+        std::cerr << "Can't load level: " << args.value("--level", "") << std::endl;
+        return 1;
+    }
+
+    if (args.has("--watch") && !levelWatcher.start(args.value("--level", "")))
+    {
+        std::cerr << "Can't watch level: " << args.value("--level", "") << std::endl;
+        return 1;
+    }
+
+    if (!init(args.value("--renderer", "curses")))
+    {
+        std::cerr << "Can't start renderer: " << args.value("--renderer", "curses") << std::endl;
+        return 1;
+    }
+
+    if (args.has("--bot-pipe"))
+    {
+        if (!botPipe.start(args.value("--bot-pipe", "")))
+        {
+            renderer->shutdown();
+            std::cerr << "Can't start bot: " << args.value("--bot-pipe", "") << std::endl;
+            return 1;
+        }
+
+        botPipe.sendReset(0);
+    }
+
+    // Bots on a pipe and the null renderer run flat out unless a rate is given
+    bool flatOut = args.has("--bot-pipe") || std::string(args.value("--renderer", "curses")) == "null";
+    scheduler = TickScheduler(args.doubleValue("--hz", flatOut ? 0 : 2),
+                              static_cast<unsigned int>(args.intValue("--max-catch-up", 5)));
+
+    if (args.has("--record"))
+    {
+        recorder = createRecorder(args.value("--record", ""));
+        recorder->begin(args.value("--record", ""));
+    }
+
+    // Rewinding would confuse recordings and bots on a pipe, they expect time to move forward
+    RewindBuffer rewinder(static_cast<unsigned int>(args.intValue("--rewind-capacity", 1024)));
+    if (args.intValue("--rewind-capacity", 1024) > 0 && !recorder && !botPipe.isRunning())
+    {
+        rewindBuffer = &rewinder;
+        rewinder.reset();
+    }
+
+    renderer->refreshScreen();
 
     update();
+    countMetric(Metric::GAMES);
+
+    if (recorder && !recorder->finish())
+        std::cerr << "Can't write recording: " << args.value("--record", "") << std::endl;
+
+    levelWatcher.stop();
+    shutdown();
+
+    if (args.has("--scores"))
+    {
+        ScoreRecord record;
+        record.score = applesEaten;
+        record.ticks = gameTick;
+        record.seed = static_cast<uint32_t>(args.intValue("--seed", 1));
+        record.flags = checkCrash() ? SCORE_FLAG_CRASHED : 0;
+        record.time = static_cast<uint64_t>(std::time(nullptr));
+        record.bot = localBot ? localBot->name : args.has("--bot-pipe") ? "pipe" : "player";
+        record.level = args.value("--level", "default");
+        record.levelHash = scoreLevelHash(record.level);
+
+        ScoreLog log;
+        bool logged = log.open(args.value("--scores", ""));
+        if (logged)
+        {
+            log.append(record);
+            logged = log.close();       // One game isn't worth rewriting the index, queries read the tail
+        }
+        if (!logged)
+            std::cerr << "Can't write score log: " << args.value("--scores", "") << std::endl;
+    }
 
-    endCurses();
+    if (args.has("--tick-stats"))
+        scheduler.printStats(std::cout);
+    std::cout << "Score: " << applesEaten << ", ticks: " << gameTick << std::endl;
 
 	return 0;
 }
 
 void update()
 {
+    typedef TickScheduler::Clock Clock;
+
+    scheduler.start();
     while (!exitGame)
     {
-        int ch = getch();
+        unsigned int steps;
+        {
+            TRACE_SCOPE("wait");
+            steps = scheduler.wait();
+        }
 
-        reactToInput(ch);
+        // Take every key that came in since the last frame
+        {
+            TRACE_SCOPE("input");
+            for (int ch = renderer->readInput(); ch != INPUT_NONE && !exitGame; ch = renderer->readInput())
+                reactToInput(ch);
+        }
 
-        drawField();
+        // Drawing and refreshing count as one frame of render time, the ticks in between don't
+        bool timed = metricsEnabled();
+        Clock::time_point drawStart = timed ? Clock::now() : Clock::time_point();
+        {
+            TRACE_SCOPE("draw");
+            drawField();
+        }
+        Clock::duration renderTime = timed ? Clock::now() - drawStart : Clock::duration();
 
-        moveSnake();
+        // More than one step when the last frame ran late
+        for (unsigned int i = 0; i < steps && !exitGame; ++i)
+        {
+            TRACE_SCOPE("tick");
+            TimingScope timing(Timing::TICK);
+            playTick();
+        }
 
-        if (checkCrash())
+        Clock::time_point refreshStart = timed ? Clock::now() : Clock::time_point();
         {
-            exitGame = true;
+            TRACE_SCOPE("refresh");
+            renderer->refreshScreen();
+        }
+        if (timed)
+            observeTiming(Timing::RENDER, renderTime + (Clock::now() - refreshStart));
+        countMetric(Metric::FRAMES);
+    }
+}
+
+void playTick()
+{
+    if (botPipe.isRunning())
+    {
+        TRACE_SCOPE("pipe bot");
+        reactToBot();
+    }
+    else if (localBot)
+    {
+        TRACE_SCOPE(localBot->name);
+        localBot->decide();
+    }
+
+    {
+        TRACE_SCOPE("step");
+        if (!stepGame())
             drawMessage("Oh no! You've crashed! Game over");
+    }
+
+    // The level file was edited, swap it in before anyone sees this tick's changes
+    std::unique_ptr<GameFieldArray> reloaded = levelWatcher.take();
+    if (reloaded && !exitGame && !swapLevel(*reloaded))
+        drawMessage("Edited level walls hit the snake, not loaded");
+
+    if (recorder)
+    {
+        TRACE_SCOPE("record");
+        recorder->tick(gameTick, fieldChanges);
+    }
+
+    if (botPipe.isRunning())
+    {
+        botPipe.sendTick(gameTick, fieldChanges);
+        if (exitGame)
+        {
+            botPipe.sendGameOver(gameTick);
+            botPipe.stop();
         }
+    }
+}
 
-        refresh();
+bool stepGame()
+{
+    clearFieldChanges();
+    const SnakeSegment tail = snake.back();
+    const size_t length = snake.size();
+    moveSnake();
+    gameTick++;
+    countMetric(Metric::TICKS);
+
+    bool crashed = checkCrash();
+    if (crashed)
+    {
+        exitGame = true;
+        emitEvent(GameEventType::CRASH, snake.front(), applesEaten);
+        countMetric(Metric::CRASHES);
     }
+
+    if (rewindBuffer)
+        rewindBuffer->record(tail, snake.size() > length);
+
+    return !crashed;
 }
 
-void loadLevel(std::string levelFile) {
-    std::ifstream lvlFile;
-    lvlFile.open(levelFile);
+bool readLevel(const std::string &levelFile, GameFieldArray &level)
+{
+    // "levels.pack:17" is level 17 of a level pack
+    std::string::size_type colon = levelFile.rfind(':');
+    if (colon != std::string::npos && colon + 1 < levelFile.size()
+        && levelFile.find_first_not_of("0123456789", colon + 1) == std::string::npos)
+    {
+        LevelPack pack;
+        errno = 0;
+        unsigned long long index = strtoull(levelFile.c_str() + colon + 1, nullptr, 10);
+        if (pack.open(levelFile.substr(0, colon)))
+            return errno == 0 && index < pack.count() && pack.verify(static_cast<uint32_t>(index))
+                && levelToField(pack.level(static_cast<uint32_t>(index)), level);
+    }
+
+    std::ifstream lvlFile(levelFile);
+    if (!lvlFile)
+        return false;
+
+    // Everything outside of the level is a wall
+    for (auto &row : level)
+    {
+        row.fill(FIELD_CHAR_WALL);
+        row[FIELD_SIZE_X - 1] = '\0';
+    }
+
     std::string line;
-    int cnt = 0;
-    while (getline(lvlFile, line)) {
-        drawString(2, FIELD_SIZE_Y + 5 + cnt, line.c_str());
-        cnt++;
+    GameFieldArray::size_type y = 0;
+    while (getline(lvlFile, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+        if (y >= FIELD_SIZE_Y || line.size() > FIELD_SIZE_X - 1)
+            return false;
+
+        for (std::string::size_type x = 0; x < line.size(); ++x)
+            level[y][x] = line[x] == FIELD_CHAR_WALL || spawnWeight(line[x]) >= 0 ? line[x] : FIELD_CHAR_EMPTY;
+        y++;
+    }
+
+    return y > 0 && isLevelClosed(level);
+}
+
+bool isLevelClosed(const GameFieldArray &level)
+{
+    for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+    {
+        if (level[0][x] != FIELD_CHAR_WALL || level[FIELD_SIZE_Y - 1][x] != FIELD_CHAR_WALL)
+            return false;
+    }
+    for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        if (level[y][0] != FIELD_CHAR_WALL || level[y][FIELD_SIZE_X - 2] != FIELD_CHAR_WALL)
+            return false;
     }
-    lvlFile.close();
+    return true;
+}
+
+void initLevel(const GameFieldArray &level)
+{
+    gameField = level;
+    appleSpawner.loadLevel(gameField);
+    gameSerial++;
+    useLevelDistances(gameField);
+    apples.reset(FIELD_SIZE_X - 1, FIELD_SIZE_Y);
+    spawnApples();
+
+    if (rewindBuffer)
+        rewindBuffer->reset();
+    emitEvent(GameEventType::LEVEL_LOADED, snake.front());
+}
+
+bool swapLevel(const GameFieldArray &newLevel)
+{
+    for (auto &segm : snake)
+    {
+        if (newLevel[segm.y][segm.x] == FIELD_CHAR_WALL)
+            return false;
+    }
+
+    GameFieldArray level = newLevel;
+    appleSpawner.loadLevel(level);
+
+    // Only cells that differ go through setFieldChar, so they show up in fieldChanges
+    std::vector<Point> kept;
+    for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            Point p(x, y);
+            if (checkCollisionWithSnake(p))
+                continue;       // The body only lives in snake and snakeCells, walls under it were refused above
+            char ch = getFieldChar(p);
+            if (ch == FIELD_CHAR_APPLE && level[y][x] != FIELD_CHAR_WALL)
+            {
+                kept.push_back(p);
+                continue;
+            }
+            if (ch == FIELD_CHAR_APPLE)
+                apples.erase(p);
+            if (ch != level[y][x])
+                setFieldChar(p, level[y][x]);
+        }
+    }
+
+    gameSerial++;
+    useLevelDistances(gameField);
+
+    for (auto &apple : kept)
+    {
+        if (levelDistances->distance(snake.front(), apple) == DIST_UNREACHABLE)
+        {
+            setFieldChar(apple, FIELD_CHAR_EMPTY);
+            apples.erase(apple);
+        }
+    }
+    spawnApples();
+
+    if (rewindBuffer)
+        rewindBuffer->reset();
+    emitEvent(GameEventType::LEVEL_LOADED, snake.front());
+    return true;
+}
+
+bool loadLevel(const std::string &levelFile)
+{
+    GameFieldArray level;
+    if (!readLevel(levelFile, level))
+        return false;
+
+    for (auto &segm : snake)
+    {
+        if (level[segm.y][segm.x] == FIELD_CHAR_WALL)
+            return false;
+    }
+
+    initLevel(level);
+    return true;
 }
 
 bool checkCrash()
@@ -131,23 +550,53 @@ void reactToInput(int key)
 {
     switch (key)
     {
-    case ERR: // Returned by curses if there were no user input
+    case INPUT_NONE: // No user input during the timeout
         break;
     case 'q':
         exitGame = true;
         drawMessage("Ok, exit game. See you next time!");
-        refresh();
+        renderer->refreshScreen();
+        break;
+    case 'r':
+        if (rewindBuffer)
+            rewindBuffer->rewind(REWIND_KEY_TICKS);
         break;
-    case KEY_UP:
+    case INPUT_UP:
         setSnakeDirection(DirectionX::NONE, DirectionY::UP);
         break;
-    case KEY_DOWN:
+    case INPUT_DOWN:
         setSnakeDirection(DirectionX::NONE, DirectionY::DOWN);
         break;
-    case KEY_LEFT:
+    case INPUT_LEFT:
         setSnakeDirection(DirectionX::LEFT, DirectionY::NONE);
         break;
-    case KEY_RIGHT:
+    case INPUT_RIGHT:
+        setSnakeDirection(DirectionX::RIGHT, DirectionY::NONE);
+        break;
+    default:
+        break;
+    }
+}
+
+void reactToBot()
+{
+    switch (botPipe.nextMove())
+    {
+    case 0: // Bot closed its pipe
+        exitGame = true;
+        drawMessage("Bot has left the game");
+        botPipe.stop();
+        break;
+    case 'U':
+        setSnakeDirection(DirectionX::NONE, DirectionY::UP);
+        break;
+    case 'D':
+        setSnakeDirection(DirectionX::NONE, DirectionY::DOWN);
+        break;
+    case 'L':
+        setSnakeDirection(DirectionX::LEFT, DirectionY::NONE);
+        break;
+    case 'R':
         setSnakeDirection(DirectionX::RIGHT, DirectionY::NONE);
         break;
     default:
@@ -158,43 +607,63 @@ void reactToInput(int key)
 void setSnakeDirection(DirectionX dirX, DirectionY dirY)
 {
     SnakeSegment &head = snake.front();
+    if (head.dirX == dirX && head.dirY == dirY)
+        return;
     head.dirX = dirX;
     head.dirY = dirY;
+    emitEvent(GameEventType::DIRECTION_CHANGE, head);
 }
 
-void endCurses()
+void shutdown()
 {
-    cbreak();
-    getch();
+    // Leave the last frame on screen until a key is pressed
+    renderer->setInputTimeout(-1);
+    renderer->readInput();
 
-    endwin();                    // Turn off curses-mode. Mandatory!
+    renderer->shutdown();
 }
 
 bool checkCollisionWithSnake(const Point &p)
 {
-    for (auto &segm : snake)
-    {
-        if (segm == p)
-        {
-            return true;
-        }
-    }
+    return snakeCells.test(fieldBit(p));
+}
 
-    return false;
+void syncSnakeCells()
+{
+    snakeCells.clear();
+    for (auto &segm : snake)
+        snakeCells.set(fieldBit(segm));
 }
 
-Point getRandomFieldPoint() { return Point(random(2, FIELD_SIZE_X - 2), random(FIELD_SIZE_Y / 2, FIELD_SIZE_Y - 2)); }
+bool canPlaceApple(const Point &p)
+{
+    return !isWall(p) && !isApple(p) && !checkCollisionWithSnake(p)
+        && !(levelDistances && levelDistances->distance(snake.front(), p) == DIST_UNREACHABLE);
+}
 
-void addApple()
+bool addApple()
 {
 	Point apple;
 
+    // Random picks are cheap while there is room, a crowded field needs the list of free cells
+    int attempts = 0;
     do
 	{
-        apple = getRandomFieldPoint();
-    } while (checkCollisionWithSnake(apple));
+        apple = appleSpawner.pick();
+    } while (!canPlaceApple(apple) && ++attempts < 64);
+
+    if (attempts == 64 && !appleSpawner.pickFree(canPlaceApple, apple))
+        return false;
 
     setFieldChar(apple, FIELD_CHAR_APPLE);
+    apples.insert(apple);
+    return true;
+}
+
+void spawnApples()
+{
+    while (apples.size() < appleTarget && addApple())
+        ;
 }
 
 bool checkAndEatApple(const SnakeSegment &head)
@@ -202,6 +671,10 @@ bool checkAndEatApple(const SnakeSegment &head)
     if (isApple(head))
 	{
         setFieldChar(head, FIELD_CHAR_EMPTY);
+        apples.erase(head);
+        applesEaten++;
+        emitEvent(GameEventType::APPLE_EATEN, head, applesEaten);
+        countMetric(Metric::APPLES_EATEN);
 		return true;
 	}
 	return false;
@@ -230,22 +703,38 @@ bool checkSelfCrash()
 
 bool moveSnake()
 {
-	auto &back = snake.back();
+	auto back = snake.back();
 	snake.pop_back();
+    snakeCells.reset(fieldBit(back));
 
     auto nextMove = getNextMove();
 
     if (checkAndEatApple(nextMove))
     {
 		snake.push_back(back);
-        addApple();
+        snakeCells.set(fieldBit(back));
+        spawnApples();
 	}
+    else
+    {
+        fieldChanges.push_back(FieldChange(back, getFieldChar(back)));
+    }
 
 	snake.push_front(nextMove);
+    snakeCells.set(fieldBit(nextMove));
+    fieldChanges.push_back(FieldChange(nextMove, FIELD_CHAR_SNAKE));
 
 	return false;
 }
 
+void clearFieldChanges()
+{
+    // The spawner's free cells follow fieldChanges, it has to see them before they go
+    appleSpawner.syncFree(canPlaceApple);
+    fieldChanges.clear();
+    appleSpawner.changesCleared();
+}
+
 SnakeSegment getNextMove()
 {
     auto &head = snake.front();
@@ -260,20 +749,18 @@ void initSnake()
 	SnakeSegment snakeHead((FIELD_SIZE_X - SNAKE_INIT_SIZE) / 2, FIELD_SIZE_Y / 2, DirectionX::LEFT, DirectionY::NONE);
 	snake.push_front(snakeHead);
 
-	SnakeSegment *prevSegment = &snakeHead;
     for (int i = 1; i < SNAKE_INIT_SIZE; ++i)
     {
-		SnakeSegment newSegment(prevSegment->x + 1, prevSegment->y, DirectionX::LEFT, DirectionY::NONE);
+		SnakeSegment newSegment(snakeHead.x + i, snakeHead.y, DirectionX::LEFT, DirectionY::NONE);
 		snake.push_back(newSegment);
-
-		prevSegment = &newSegment;
 	}
+    syncSnakeCells();
 }
 
 void drawField()
 {
     GameFieldArray &field = gameField;
-    clear();
+    renderer->clearScreen();
 
     // Draw field itself
     for (GameFieldArray::size_type i = 0; i < FIELD_SIZE_Y; ++i)
@@ -289,23 +776,31 @@ void drawField()
 	}
 }
 
-void initCurses()
+bool init(const std::string &rendererName)
 {
-    initscr();              // Go to curses-mode
-    keypad(stdscr, true);   // Turn on function keys reading
+    renderer = createRenderer(rendererName);
+    if (!renderer || !renderer->init())
+        return false;
 
-    noecho();
-    halfdelay(5);
-
-    curs_set(0);
+    renderer->setInputTimeout(0);    // The tick scheduler sets the pace
+    return true;
 }
 
-void init()
+void initGame(unsigned int seed)
 {
+    seedRandom(seed);
+
+    exitGame = false;
+    gameSerial++;
+    gameTick = 0;
+    applesEaten = 0;
+
     initSnake();
     initField();
+    clearFieldChanges();
 
-    initCurses();
+    if (rewindBuffer)
+        rewindBuffer->reset();
 }
 
 void initField()
@@ -333,11 +828,21 @@ void initField()
         }
 	}
 
-    addApple();
+    appleSpawner.useDefault();
+    useLevelDistances(gameField);
+    apples.reset(FIELD_SIZE_X - 1, FIELD_SIZE_Y);
+    spawnApples();
+}
+
+void seedRandom(unsigned int seed)
+{
+    randomEngine.seed(seed);
+    randomDraws = 0;
 }
 
 unsigned int random(unsigned int min, unsigned int max)
 {
-    unsigned int rnd = static_cast<unsigned int>(rand());
+    randomDraws++;
+    unsigned int rnd = static_cast<unsigned int>(randomEngine());
     return rnd % (max - min) + min;
 }
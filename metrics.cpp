@@ -0,0 +1,328 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "metrics.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+const int METRICS_POLL_MS = 100;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;   // A scraper hanging up early must not kill the game with SIGPIPE
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+static const MetricInfo counterInfo[] = {
+    { "snake_ticks_total", "Game ticks simulated." },
+    { "snake_frames_total", "Frames drawn." },
+    { "snake_apples_eaten_total", "Apples eaten." },
+    { "snake_games_total", "Games finished." },
+    { "snake_crashes_total", "Games that ended in a crash." },
+    { "snake_terminal_bytes_total", "Bytes written to the terminal by the ANSI renderer." },
+};
+
+static const MetricInfo timingInfo[] = {
+    { "snake_tick_seconds", "Time to decide and play one tick." },
+    { "snake_render_seconds", "Time to draw and refresh one frame." },
+};
+
+/**
+* Only the owning thread writes a block, relaxed loads and stores are enough
+* for it and let the scraper read without tearing.
+*/
+struct ThreadMetrics {
+    std::atomic<uint64_t> counters[static_cast<int>(Metric::COUNT)];
+    std::atomic<uint64_t> buckets[static_cast<int>(Timing::COUNT)][METRIC_BUCKETS];
+    std::atomic<uint64_t> sumNs[static_cast<int>(Timing::COUNT)];
+
+    ThreadMetrics()
+    {
+        for (auto &c : counters)
+            c.store(0, std::memory_order_relaxed);
+        for (auto &timing : buckets)
+            for (auto &b : timing)
+                b.store(0, std::memory_order_relaxed);
+        for (auto &s : sumNs)
+            s.store(0, std::memory_order_relaxed);
+    }
+};
+
+static void add(std::atomic<uint64_t> &value, uint64_t amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+std::atomic<bool> metricsOn(false);
+
+static std::mutex blocksMutex;
+static std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+static thread_local ThreadMetrics* threadMetrics = nullptr;
+
+MetricsExporter metricsExporter;
+
+static ThreadMetrics &localMetrics()
+{
+    if (!threadMetrics)
+    {
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        blocks.push_back(std::unique_ptr<ThreadMetrics>(new ThreadMetrics()));
+        threadMetrics = blocks.back().get();
+    }
+    return *threadMetrics;
+}
+
+void enableMetrics()
+{
+    metricsOn.store(true, std::memory_order_relaxed);
+}
+
+void countMetric(Metric metric, uint64_t amount)
+{
+    if (!metricsEnabled())
+        return;
+    add(localMetrics().counters[static_cast<int>(metric)], amount);
+}
+
+void observeTiming(Timing timing, std::chrono::steady_clock::duration elapsed)
+{
+    if (!metricsEnabled())
+        return;
+
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    int bucket = 0;
+    for (uint64_t limit = 1000; bucket < METRIC_BUCKETS - 1 && ns > limit; limit <<= 1)
+        bucket++;
+
+    ThreadMetrics &local = localMetrics();
+    add(local.buckets[static_cast<int>(timing)][bucket], 1);
+    add(local.sumNs[static_cast<int>(timing)], ns);
+}
+
+void writeMetrics(std::ostream &out)
+{
+    uint64_t counters[static_cast<int>(Metric::COUNT)] = {};
+    uint64_t buckets[static_cast<int>(Timing::COUNT)][METRIC_BUCKETS] = {};
+    uint64_t sumNs[static_cast<int>(Timing::COUNT)] = {};
+
+    {
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        for (auto &block : blocks)
+        {
+            for (int i = 0; i < static_cast<int>(Metric::COUNT); ++i)
+                counters[i] += block->counters[i].load(std::memory_order_relaxed);
+            for (int t = 0; t < static_cast<int>(Timing::COUNT); ++t)
+            {
+                for (int b = 0; b < METRIC_BUCKETS; ++b)
+                    buckets[t][b] += block->buckets[t][b].load(std::memory_order_relaxed);
+                sumNs[t] += block->sumNs[t].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(Metric::COUNT); ++i)
+    {
+        out << "# HELP " << counterInfo[i].name << ' ' << counterInfo[i].help << '\n'
+            << "# TYPE " << counterInfo[i].name << " counter\n"
+            << counterInfo[i].name << ' ' << counters[i] << '\n';
+    }
+
+    for (int t = 0; t < static_cast<int>(Timing::COUNT); ++t)
+    {
+        const char* name = timingInfo[t].name;
+        out << "# HELP " << name << ' ' << timingInfo[t].help << '\n'
+            << "# TYPE " << name << " histogram\n";
+
+        // Prometheus buckets are cumulative
+        uint64_t total = 0;
+        for (int b = 0; b < METRIC_BUCKETS; ++b)
+        {
+            total += buckets[t][b];
+            out << name << "_bucket{le=\"";
+            if (b == METRIC_BUCKETS - 1)
+                out << "+Inf";
+            else
+                out << static_cast<double>(1ULL << b) * 1e-6;
+            out << "\"} " << total << '\n';
+        }
+        out << name << "_sum " << static_cast<double>(sumNs[t]) * 1e-9 << '\n'
+            << name << "_count " << total << '\n';
+    }
+}
+
+MetricsExporter::MetricsExporter() : intervalMs(1000), listenFd(-1), running(false)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start(const std::string &exportTarget, unsigned int interval)
+{
+    stop();
+
+    target = exportTarget;
+    intervalMs = interval > 0 ? interval : 1000;
+
+    if (target.compare(0, 5, "unix:") == 0)
+    {
+#ifdef _WIN32
+        return false;
+#else
+        socketPath = target.substr(5);
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path))
+            return false;
+        socketPath.copy(addr.sun_path, socketPath.size());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0)
+            return false;
+
+        // A socket left behind by an earlier run would make bind() fail, anything else there stays
+        struct stat existing;
+        if (lstat(socketPath.c_str(), &existing) == 0)
+        {
+            if (!S_ISSOCK(existing.st_mode))
+            {
+                close(listenFd);
+                listenFd = -1;
+                return false;
+            }
+            unlink(socketPath.c_str());
+        }
+        if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 8) != 0)
+        {
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+
+        enableMetrics();
+        running = true;
+        thread = std::thread(&MetricsExporter::serveLoop, this);
+        return true;
+#endif
+    }
+
+    if (!writeFile())
+        return false;
+
+    enableMetrics();
+    running = true;
+    thread = std::thread(&MetricsExporter::writeFileLoop, this);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (!running)
+        return;
+
+    running = false;
+    thread.join();
+
+#ifndef _WIN32
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        unlink(socketPath.c_str());
+        return;
+    }
+#endif
+    writeFile();
+}
+
+bool MetricsExporter::writeFile()
+{
+    std::string tmpFile = target + ".tmp";
+    {
+        std::ofstream stream(tmpFile);
+        writeMetrics(stream);
+        if (!stream)
+            return false;
+    }
+#ifdef _WIN32
+    std::remove(target.c_str());    // Windows won't rename over an existing file
+#endif
+    return std::rename(tmpFile.c_str(), target.c_str()) == 0;
+}
+
+void MetricsExporter::writeFileLoop()
+{
+    unsigned int waited = 0;
+    while (running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(METRICS_POLL_MS));
+        waited += METRICS_POLL_MS;
+        if (waited >= intervalMs)
+        {
+            writeFile();
+            waited = 0;
+        }
+    }
+}
+
+void MetricsExporter::serveLoop()
+{
+#ifndef _WIN32
+    while (running)
+    {
+        struct pollfd listening = { listenFd, POLLIN, 0 };
+        if (poll(&listening, 1, METRICS_POLL_MS) <= 0)
+            continue;
+
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        // A scraper speaking HTTP sends its request first, a plain reader may send nothing
+        char request[512];
+        ssize_t size = 0;
+        struct pollfd reading = { client, POLLIN, 0 };
+        if (poll(&reading, 1, METRICS_POLL_MS) > 0)
+            size = read(client, request, sizeof(request));
+
+        std::ostringstream body;
+        writeMetrics(body);
+
+        std::string reply;
+        if (size >= 4 && std::string(request, 4) == "GET ")
+        {
+            reply = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                  + std::to_string(body.str().size()) + "\r\n\r\n";
+        }
+        reply += body.str();
+
+        const char* data = reply.data();
+        size_t left = reply.size();
+        while (left > 0)
+        {
+            ssize_t done = send(client, data, left, SEND_FLAGS);
+            if (done <= 0)
+                break;
+            data += done;
+            left -= static_cast<size_t>(done);
+        }
+        close(client);
+    }
+#endif
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/**
+* Counters and histograms in the Prometheus text exposition format.
+*
+* Every thread counts into its own block, so the game never shares a cache
+* line or takes a lock to count. Blocks are only summed up when somebody
+* asks for the metrics, and stay around after their thread is gone so the
+* totals of a finished tournament worker don't disappear.
+*
+* Nothing is counted until enableMetrics(), the game checks metricsEnabled()
+* before it reads a clock.
+*/
+enum class Metric {
+    TICKS,
+    FRAMES,
+    APPLES_EATEN,
+    GAMES,
+    CRASHES,
+    TERMINAL_BYTES,
+    COUNT
+};
+
+enum class Timing {
+    TICK,           // Bot decision and game step
+    RENDER,         // Drawing and refreshing a frame
+    COUNT
+};
+
+// Log2 buckets from 1 us up to about 1 s, plus +Inf
+const int METRIC_BUCKETS = 22;
+
+extern std::atomic<bool> metricsOn;
+
+void enableMetrics();
+inline bool metricsEnabled() { return metricsOn.load(std::memory_order_relaxed); }
+
+void countMetric(Metric metric, uint64_t amount = 1);
+void observeTiming(Timing timing, std::chrono::steady_clock::duration elapsed);
+
+void writeMetrics(std::ostream &out);
+
+/**
+* Times a scope into a histogram when metrics are on.
+*/
+class TimingScope {
+public:
+    explicit TimingScope(Timing timing) : timing(timing), enabled(metricsEnabled())
+    {
+        if (enabled)
+            start = std::chrono::steady_clock::now();
+    }
+    ~TimingScope()
+    {
+        if (enabled)
+            observeTiming(timing, std::chrono::steady_clock::now() - start);
+    }
+
+private:
+    Timing timing;
+    bool enabled;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+* Publishes the metrics for a scraper.
+*
+* "unix:/path" serves them on a Unix domain socket, a plain GET gets an HTTP
+* answer and anything else just the text. Any other target is a file that is
+* rewritten every interval through a temporary file and rename(), so a reader
+* never sees half of it.
+*/
+class MetricsExporter {
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    bool start(const std::string &target, unsigned int intervalMs);
+    void stop();        // Writes the file one last time
+
+private:
+    void writeFileLoop();
+    void serveLoop();
+    bool writeFile();
+
+    std::string target;
+    std::string socketPath;
+    unsigned int intervalMs;
+    int listenFd;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+extern MetricsExporter metricsExporter;
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include "mlp.h"
+#include "bots.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MLP_HAVE_AVX2 1
+#define MLP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+static bool cpuHasAvx2() { return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"); }
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#include <intrin.h>
+#define MLP_HAVE_AVX2 1
+#define MLP_TARGET_AVX2
+static bool cpuHasAvx2()
+{
+    int info[4];
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    return avx2 && fma;
+}
+#else
+#define MLP_HAVE_AVX2 0
+static bool cpuHasAvx2() { return false; }
+#endif
+
+const int MLP_LANES = 8;
+const size_t MLP_ALIGN = 32;
+const int MLP_AVX2_CHUNK = 64;         // Hidden units the AVX2 kernel keeps in registers at a time
+
+Mlp policyNet;
+
+static int padToLanes(int n) { return (n + MLP_LANES - 1) / MLP_LANES * MLP_LANES; }
+
+Mlp::Mlp() : inputs(0), paddedInputs(0), hidden(0), paddedHidden(0),
+             w1tOffset(0), b1Offset(0), w2Offset(0), b2Offset(0), useAvx2(cpuHasAvx2())
+{
+}
+
+void Mlp::resize(int _inputs, int _hidden)
+{
+    inputs = _inputs;
+    hidden = _hidden;
+    paddedInputs = padToLanes(inputs);
+    paddedHidden = padToLanes(hidden);
+
+    w1tOffset = 0;
+    b1Offset = w1tOffset + static_cast<size_t>(paddedInputs) * paddedHidden;
+    w2Offset = b1Offset + paddedHidden;
+    b2Offset = w2Offset + static_cast<size_t>(MLP_OUTPUTS) * paddedHidden;
+
+    // Extra floats to align the start to 32 bytes
+    storage.assign(b2Offset + MLP_OUTPUTS + MLP_ALIGN / sizeof(float), 0.0f);
+}
+
+const float* Mlp::alignedData(size_t offset) const
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(storage.data());
+    base = (base + MLP_ALIGN - 1) & ~static_cast<uintptr_t>(MLP_ALIGN - 1);
+    return reinterpret_cast<const float*>(base) + offset;
+}
+
+float* Mlp::alignedData(size_t offset)
+{
+    return const_cast<float*>(static_cast<const Mlp*>(this)->alignedData(offset));
+}
+
+static bool readU32(std::istream &in, uint32_t &value)
+{
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), 4))
+        return false;
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    return true;
+}
+
+static bool readFloat(std::istream &in, float &value)
+{
+    uint32_t bits;
+    if (!readU32(in, bits))
+        return false;
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+static void writeU32(std::ostream &out, uint32_t value)
+{
+    unsigned char bytes[4] = {
+        static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+        static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)
+    };
+    out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+static void writeFloat(std::ostream &out, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeU32(out, bits);
+}
+
+bool Mlp::load(const std::string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    uint32_t magic, fileInputs, fileHidden;
+    if (!readU32(in, magic) || !readU32(in, fileInputs) || !readU32(in, fileHidden))
+        return false;
+    if (magic != MLP_MAGIC || fileInputs != MLP_INPUTS || fileHidden == 0 || fileHidden > 4096)
+        return false;
+
+    resize(fileInputs, fileHidden);
+
+    float* w1t = alignedData(w1tOffset);
+    for (int h = 0; h < hidden; ++h)
+    {
+        for (int i = 0; i < inputs; ++i)
+        {
+            if (!readFloat(in, w1t[i * paddedHidden + h]))
+                return false;
+        }
+    }
+    for (int h = 0; h < hidden; ++h)
+    {
+        if (!readFloat(in, alignedData(b1Offset)[h]))
+            return false;
+    }
+    for (int o = 0; o < MLP_OUTPUTS; ++o)
+    {
+        for (int h = 0; h < hidden; ++h)
+        {
+            if (!readFloat(in, alignedData(w2Offset)[o * paddedHidden + h]))
+                return false;
+        }
+    }
+    for (int o = 0; o < MLP_OUTPUTS; ++o)
+    {
+        if (!readFloat(in, alignedData(b2Offset)[o]))
+            return false;
+    }
+    return true;
+}
+
+bool Mlp::save(const std::string &file) const
+{
+    std::ofstream out(file, std::ios::binary);
+    writeU32(out, MLP_MAGIC);
+    writeU32(out, inputs);
+    writeU32(out, hidden);
+
+    const float* w1t = alignedData(w1tOffset);
+    for (int h = 0; h < hidden; ++h)
+    {
+        for (int i = 0; i < inputs; ++i)
+            writeFloat(out, w1t[i * paddedHidden + h]);
+    }
+    for (int h = 0; h < hidden; ++h)
+        writeFloat(out, alignedData(b1Offset)[h]);
+    for (int o = 0; o < MLP_OUTPUTS; ++o)
+    {
+        for (int h = 0; h < hidden; ++h)
+            writeFloat(out, alignedData(w2Offset)[o * paddedHidden + h]);
+    }
+    for (int o = 0; o < MLP_OUTPUTS; ++o)
+        writeFloat(out, alignedData(b2Offset)[o]);
+
+    return static_cast<bool>(out);
+}
+
+void Mlp::randomize(int _hidden, unsigned int seed)
+{
+    resize(MLP_INPUTS, _hidden);
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> w1(0.0f, 1.0f / std::sqrt(static_cast<float>(inputs)));
+    std::normal_distribution<float> w2(0.0f, 1.0f / std::sqrt(static_cast<float>(hidden)));
+
+    for (int i = 0; i < inputs; ++i)
+    {
+        for (int h = 0; h < hidden; ++h)
+            alignedData(w1tOffset)[i * paddedHidden + h] = w1(rng);
+    }
+    for (int o = 0; o < MLP_OUTPUTS; ++o)
+    {
+        for (int h = 0; h < hidden; ++h)
+            alignedData(w2Offset)[o * paddedHidden + h] = w2(rng);
+    }
+}
+
+void Mlp::forwardBatch(const float* input, size_t count, float* output) const
+{
+#if MLP_HAVE_AVX2
+    if (useAvx2)
+        return forwardAvx2(input, count, output);
+#endif
+    forwardScalar(input, count, output);
+}
+
+// Same arithmetic as forwardAvx2Kernel(), fused multiply-adds in the same order
+// and the same pairwise sum of the 8 lanes, so both play the same games
+void Mlp::forwardScalar(const float* input, size_t count, float* output) const
+{
+    const float* w1t = alignedData(w1tOffset);
+    const float* b1 = alignedData(b1Offset);
+    const float* w2 = alignedData(w2Offset);
+    const float* b2 = alignedData(b2Offset);
+
+    // One model serves every thread, so the scratch row is per thread, not a member
+    static thread_local std::vector<float> act;
+    if (act.size() < static_cast<size_t>(paddedHidden))
+        act.resize(paddedHidden);
+
+    for (size_t n = 0; n < count; ++n, input += paddedInputs, output += MLP_OUTPUTS)
+    {
+        std::copy(b1, b1 + paddedHidden, act.begin());
+        for (int i = 0; i < inputs; ++i)
+        {
+            const float x = input[i];
+            if (x == 0.0f)
+                continue;
+            const float* row = w1t + i * paddedHidden;
+            for (int h = 0; h < paddedHidden; ++h)
+                act[h] = std::fma(x, row[h], act[h]);
+        }
+
+        for (int h = 0; h < paddedHidden; ++h)
+            act[h] = act[h] > 0.0f ? act[h] : 0.0f;
+
+        for (int o = 0; o < MLP_OUTPUTS; ++o)
+        {
+            float lanes[MLP_LANES] = {};
+            const float* row = w2 + o * paddedHidden;
+            for (int h = 0; h < paddedHidden; h += MLP_LANES)
+            {
+                for (int l = 0; l < MLP_LANES; ++l)
+                    lanes[l] = std::fma(act[h + l], row[h + l], lanes[l]);
+            }
+
+            float quad[4];
+            for (int l = 0; l < 4; ++l)
+                quad[l] = lanes[l] + lanes[l + 4];
+            output[o] = b2[o] + ((quad[0] + quad[2]) + (quad[1] + quad[3]));
+        }
+    }
+}
+
+#if MLP_HAVE_AVX2
+
+static MLP_TARGET_AVX2 inline float horizontalSum(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+// Hidden layer is vectorized over neurons: act += x[i] * w1t[i][h..h+7].
+// Wide layers go through in chunks, the output sums carry on across them in the same order.
+static MLP_TARGET_AVX2 void forwardAvx2Kernel(const float* w1t, const float* b1, const float* w2, const float* b2,
+                                              int inputs, int paddedInputs, int paddedHidden,
+                                              const float* input, size_t count, float* output)
+{
+    const int blocks = paddedHidden / MLP_LANES;
+    const int chunkBlocks = MLP_AVX2_CHUNK / MLP_LANES;
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 acc[MLP_AVX2_CHUNK / MLP_LANES];
+    __m256 sum[MLP_OUTPUTS];
+
+    for (size_t n = 0; n < count; ++n, input += paddedInputs, output += MLP_OUTPUTS)
+    {
+        for (int o = 0; o < MLP_OUTPUTS; ++o)
+            sum[o] = zero;
+
+        for (int first = 0; first < blocks; first += chunkBlocks)
+        {
+            const int chunk = std::min(chunkBlocks, blocks - first);
+            const int offset = first * MLP_LANES;
+
+            for (int b = 0; b < chunk; ++b)
+                acc[b] = _mm256_load_ps(b1 + offset + b * MLP_LANES);
+
+            for (int i = 0; i < inputs; ++i)
+            {
+                if (input[i] == 0.0f)
+                    continue;
+                const __m256 x = _mm256_set1_ps(input[i]);
+                const float* row = w1t + i * paddedHidden + offset;
+                for (int b = 0; b < chunk; ++b)
+                    acc[b] = _mm256_fmadd_ps(x, _mm256_load_ps(row + b * MLP_LANES), acc[b]);
+            }
+
+            for (int b = 0; b < chunk; ++b)
+                acc[b] = _mm256_max_ps(acc[b], zero);
+
+            for (int o = 0; o < MLP_OUTPUTS; ++o)
+            {
+                const float* row = w2 + o * paddedHidden + offset;
+                for (int b = 0; b < chunk; ++b)
+                    sum[o] = _mm256_fmadd_ps(acc[b], _mm256_load_ps(row + b * MLP_LANES), sum[o]);
+            }
+        }
+
+        for (int o = 0; o < MLP_OUTPUTS; ++o)
+            output[o] = b2[o] + horizontalSum(sum[o]);
+    }
+}
+
+void Mlp::forwardAvx2(const float* input, size_t count, float* output) const
+{
+    forwardAvx2Kernel(alignedData(w1tOffset), alignedData(b1Offset), alignedData(w2Offset), alignedData(b2Offset),
+                      inputs, paddedInputs, paddedHidden, input, count, output);
+}
+
+#else
+
+void Mlp::forwardAvx2(const float* input, size_t count, float* output) const
+{
+    forwardScalar(input, count, output);
+}
+
+#endif
+
+void mlpInput(float* input)
+{
+    const Point head = snake.front();
+    std::memset(input, 0, sizeof(float) * policyNet.paddedInputCount());
+
+    const int half = MLP_WINDOW / 2;
+    for (int dy = -half; dy <= half; ++dy)
+    {
+        for (int dx = -half; dx <= half; ++dx)
+        {
+            int x = static_cast<int>(head.x) + dx;
+            int y = static_cast<int>(head.y) + dy;
+            float value = 1.0f;
+            if (x >= 0 && y >= 0 && x < FIELD_SIZE_X - 1 && y < FIELD_SIZE_Y)
+            {
+                char ch = gameField[y][x];
+                value = ch == FIELD_CHAR_WALL ? 1.0f : (ch == FIELD_CHAR_APPLE ? -1.0f : 0.0f);
+            }
+            input[(dy + half) * MLP_WINDOW + dx + half] = value;
+        }
+    }
+
+    for (auto &segm : snake)
+    {
+        int dx = static_cast<int>(segm.x) - static_cast<int>(head.x);
+        int dy = static_cast<int>(segm.y) - static_cast<int>(head.y);
+        if (dx >= -half && dx <= half && dy >= -half && dy <= half)
+            input[(dy + half) * MLP_WINDOW + dx + half] = 1.0f;
+    }
+
+    Point apple;
+    if (findApple(apple))
+    {
+        input[MLP_WINDOW * MLP_WINDOW] = (static_cast<float>(apple.x) - head.x) / FIELD_SIZE_X;
+        input[MLP_WINDOW * MLP_WINDOW + 1] = (static_cast<float>(apple.y) - head.y) / FIELD_SIZE_Y;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+* Small fully connected policy network for the "mlp" bot:
+* inputs -> hidden (ReLU) -> 4 move scores (up, down, left, right).
+*
+* Inputs are a MLP_WINDOW x MLP_WINDOW window of the field around the head
+* (1 - blocked, -1 - apple, 0 - empty) followed by the apple offset.
+*
+* Weights file, little-endian:
+*   u32 MLP_MAGIC, u32 inputs, u32 hidden,
+*   f32 w1[hidden][inputs], f32 b1[hidden], f32 w2[4][hidden], f32 b2[4]
+*/
+const int MLP_WINDOW = 7;
+const int MLP_INPUTS = MLP_WINDOW * MLP_WINDOW + 2;
+const int MLP_OUTPUTS = 4;
+const unsigned int MLP_MAGIC = 0x504C4D53;   // "SMLP"
+
+class Mlp {
+public:
+    Mlp();
+
+    bool load(const std::string &file);
+    bool save(const std::string &file) const;
+    void randomize(int hidden, unsigned int seed);
+
+    int inputCount() const { return inputs; }
+    int paddedInputCount() const { return paddedInputs; }
+
+    // Inputs are count rows of paddedInputCount() floats, outputs are count rows of MLP_OUTPUTS.
+    // The mlp bot passes one row, every thread plays its own game and decides alone.
+    // AVX2 and the scalar fallback give bit identical scores.
+    void forwardBatch(const float* input, size_t count, float* output) const;
+
+private:
+    void resize(int inputs, int hidden);
+    float* alignedData(size_t offset);
+    const float* alignedData(size_t offset) const;
+
+    void forwardScalar(const float* input, size_t count, float* output) const;
+    void forwardAvx2(const float* input, size_t count, float* output) const;
+
+    int inputs;
+    int paddedInputs;
+    int hidden;
+    int paddedHidden;
+
+    // Weights are stored transposed and zero padded to 8 floats:
+    // w1t[paddedInputs][paddedHidden], b1[paddedHidden], w2[4][paddedHidden], b2[4]
+    std::vector<float> storage;
+    size_t w1tOffset, b1Offset, w2Offset, b2Offset;
+
+    bool useAvx2;
+};
+
+extern Mlp policyNet;
+
+// Fills paddedInputCount() floats from the current game state
+void mlpInput(float* input);
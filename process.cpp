@@ -0,0 +1,114 @@
+#include "process.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+ChildProcess::ChildProcess() : pid(-1), toChild(-1), fromChild(-1)
+{
+}
+
+ChildProcess::~ChildProcess()
+{
+    if (isRunning())
+        wait();
+}
+
+#ifndef _WIN32
+
+bool ChildProcess::start(const char* command)
+{
+    int in[2], out[2];
+    if (pipe(in) != 0)
+        return false;
+    if (pipe(out) != 0)
+    {
+        close(in[0]);
+        close(in[1]);
+        return false;
+    }
+
+    // Dead child must not kill us on write
+    signal(SIGPIPE, SIG_IGN);
+
+    pid = fork();
+    if (pid < 0)
+    {
+        close(in[0]); close(in[1]);
+        close(out[0]); close(out[1]);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        close(in[0]); close(in[1]);
+        close(out[0]); close(out[1]);
+        execl("/bin/sh", "sh", "-c", command, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(in[0]);
+    close(out[1]);
+    toChild = in[1];
+    fromChild = out[0];
+    return true;
+}
+
+bool ChildProcess::writeAll(const void* data, size_t size)
+{
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        ssize_t written = write(toChild, ptr, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+long ChildProcess::readSome(void* buf, size_t size)
+{
+    for (;;)
+    {
+        ssize_t got = read(fromChild, buf, size);
+        if (got < 0 && errno == EINTR)
+            continue;
+        return static_cast<long>(got);
+    }
+}
+
+int ChildProcess::wait()
+{
+    if (toChild >= 0)
+        close(toChild);
+    if (fromChild >= 0)
+        close(fromChild);
+    toChild = fromChild = -1;
+
+    int status = 0;
+    if (pid > 0)
+        waitpid(pid, &status, 0);
+    pid = -1;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+#else
+
+bool ChildProcess::start(const char*) { return false; }
+bool ChildProcess::writeAll(const void*, size_t) { return false; }
+long ChildProcess::readSome(void*, size_t) { return -1; }
+int ChildProcess::wait() { pid = -1; return -1; }
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+* Child process connected to us by two pipes:
+* we write to its stdin and read from its stdout.
+* Only implemented for POSIX systems, start() fails on Windows.
+*/
+class ChildProcess {
+public:
+    ChildProcess();
+    ~ChildProcess();
+
+    bool start(const char* command);     // Command is run with /bin/sh -c
+
+    bool isRunning() const { return pid > 0; }
+
+    bool writeAll(const void* data, size_t size);
+    long readSome(void* buf, size_t size);   // Blocks. Returns 0 on EOF and -1 on error
+
+    int wait();                          // Closes pipes and returns child exit code
+
+private:
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    int pid;
+    int toChild;
+    int fromChild;
+};
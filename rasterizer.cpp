@@ -0,0 +1,184 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "rasterizer.h"
+#include "recorder.h"
+#include "snake.h"
+#include "tournament.h"
+
+struct TileStyle {
+    char ch;
+    uint8_t fg[3];
+    uint8_t bg[3];
+    uint8_t mask[8];    // 8x8 glyph, top row first, high bit on the left
+};
+
+static const TileStyle TILE_STYLES[] = {
+    { FIELD_CHAR_EMPTY, { 0, 0, 0 }, { 16, 16, 24 }, { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { FIELD_CHAR_WALL, { 150, 150, 160 }, { 90, 90, 100 }, { 0xFF, 0x88, 0x88, 0xFF, 0xFF, 0x22, 0x22, 0xFF } },
+    { FIELD_CHAR_SNAKE, { 60, 200, 80 }, { 16, 16, 24 }, { 0x00, 0x3C, 0x7E, 0x7E, 0x7E, 0x7E, 0x3C, 0x00 } },
+    { FIELD_CHAR_APPLE, { 220, 40, 40 }, { 16, 16, 24 }, { 0x08, 0x10, 0x3C, 0x7E, 0x7E, 0x7E, 0x3C, 0x00 } },
+};
+const int TILE_STYLE_COUNT = sizeof(TILE_STYLES) / sizeof(TILE_STYLES[0]);
+
+TileAtlas::TileAtlas(int tileSize) : size(tileSize), tiles(TILE_STYLE_COUNT * tileSize * tileSize * 3)
+{
+    for (int t = 0; t < TILE_STYLE_COUNT; ++t)
+    {
+        const TileStyle &style = TILE_STYLES[t];
+        uint8_t* out = &tiles[t * size * size * 3];
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x, out += 3)
+            {
+                bool on = (style.mask[y * 8 / size] >> (7 - x * 8 / size)) & 1;
+                std::memcpy(out, on ? style.fg : style.bg, 3);
+            }
+        }
+    }
+}
+
+const uint8_t* TileAtlas::tile(char ch) const
+{
+    for (int t = 0; t < TILE_STYLE_COUNT; ++t)
+    {
+        if (TILE_STYLES[t].ch == ch)
+            return &tiles[t * size * size * 3];
+    }
+    return &tiles[0];
+}
+
+void rasterizeFrame(const TileAtlas &atlas, const char* cells, int width, int height, std::vector<uint8_t> &rgb)
+{
+    const int tile = atlas.tileSize();
+    const size_t rowBytes = static_cast<size_t>(width) * tile * 3;
+    const size_t tileRowBytes = static_cast<size_t>(tile) * 3;
+    rgb.resize(rowBytes * height * tile);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const uint8_t* src = atlas.tile(cells[y * width + x]);
+            uint8_t* dst = &rgb[y * tile * rowBytes + x * tileRowBytes];
+            for (int row = 0; row < tile; ++row, src += tileRowBytes, dst += rowBytes)
+                std::memcpy(dst, src, tileRowBytes);
+        }
+    }
+}
+
+static std::string ppmHeader(int width, int height)
+{
+    return "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+}
+
+int runRasterizer(const Args &args)
+{
+    RecordingReader reader;
+    if (!reader.open(args.value("--rasterize", "")))
+    {
+        std::cerr << "Can't read recording: " << args.value("--rasterize", "") << std::endl;
+        return 1;
+    }
+
+    std::string outDir = args.value("--out-dir", ".");
+    bool toStdout = std::string(args.value("--out", "")) == "-";
+    unsigned int from = static_cast<unsigned int>(args.intValue("--from", 0));
+    unsigned int to = static_cast<unsigned int>(args.intValue("--to", -1));
+    unsigned int threads = threadCount(args);
+
+    long tileSize = args.intValue("--tile", 16);
+    if (tileSize < 1 || tileSize > 256)
+    {
+        std::cerr << "Tile size must be 1..256" << std::endl;
+        return 1;
+    }
+    TileAtlas atlas(static_cast<int>(tileSize));
+
+    if (!reader.seek(from))
+    {
+        std::cerr << "Recording is shorter than tick " << from << std::endl;
+        return 1;
+    }
+
+    const int width = reader.width();
+    const int height = reader.height();
+    const size_t frameCells = static_cast<size_t>(width) * height;
+    const std::string header = ppmHeader(width * atlas.tileSize(), height * atlas.tileSize());
+
+    // States are decoded in order, then a batch of frames is rasterized and encoded in parallel
+    const size_t batchSize = threads * 8;
+    std::vector<char> batchCells(batchSize * frameCells);
+    std::vector<unsigned int> batchTicks(batchSize);
+    std::vector<std::vector<uint8_t>> images(batchSize);
+    std::vector<uint8_t> failed(batchSize);     // Not vector<bool>, its bits share words between threads
+
+    unsigned long long frames = 0;
+    bool more = true;
+    while (more)
+    {
+        size_t count = 0;
+        while (count < batchSize && more && reader.currentTick() <= to)
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                    batchCells[count * frameCells + y * width + x] = reader.cell(x, y);
+            }
+            batchTicks[count++] = reader.currentTick();
+            more = reader.next();
+        }
+        more = more && reader.currentTick() <= to;
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < count; i = next++)
+            {
+                rasterizeFrame(atlas, &batchCells[i * frameCells], width, height, images[i]);
+                failed[i] = false;
+                if (toStdout)
+                    continue;
+
+                char name[32];
+                snprintf(name, sizeof(name), "/frame_%06u.ppm", batchTicks[i]);
+                FILE* file = fopen((outDir + name).c_str(), "wb");
+                failed[i] = !file || fwrite(header.data(), 1, header.size(), file) != header.size()
+                         || fwrite(images[i].data(), 1, images[i].size(), file) != images[i].size();
+                if (file)
+                    failed[i] = fclose(file) != 0 || failed[i];
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned int i = 1; i < threads; ++i)
+            pool.push_back(std::thread(worker));
+        worker();
+        for (auto &thread : pool)
+            thread.join();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (toStdout)
+            {
+                fwrite(header.data(), 1, header.size(), stdout);
+                fwrite(images[i].data(), 1, images[i].size(), stdout);
+            }
+            else if (failed[i])
+            {
+                std::cerr << "Can't write frame " << batchTicks[i] << " to " << outDir << std::endl;
+                return 1;
+            }
+        }
+        frames += count;
+    }
+
+    if (toStdout)
+        fflush(stdout);
+    else
+        std::cout << frames << " frames written to " << outDir << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "args.h"
+
+/**
+* Offline renderer of game frames into RGB images.
+* Every cell kind has a tile in an atlas built once for the tile size,
+* so a frame is a tile copy per cell.
+*
+*   --rasterize recording.sdr [--out-dir dir | --out -] [--tile N]
+*   [--from tick] [--to tick] [--threads N]
+*
+* With --out-dir every tick becomes frame_NNNNNN.ppm,
+* "--out -" writes a stream of PPM images to stdout for ffmpeg.
+*/
+class TileAtlas {
+public:
+    explicit TileAtlas(int tileSize);
+
+    int tileSize() const { return size; }
+    const uint8_t* tile(char ch) const;     // size * size RGB pixels
+
+private:
+    int size;
+    std::vector<uint8_t> tiles;             // One tile per cell kind
+};
+
+// Fills rgb (width * tile x height * tile RGB pixels) from width * height cells
+void rasterizeFrame(const TileAtlas &atlas, const char* cells, int width, int height, std::vector<uint8_t> &rgb);
+
+int runRasterizer(const Args &args);
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <iterator>
+#include "recorder.h"
+#include "renderer.h"
+
+const char RECORD_MAGIC[] = "SNKREC1\n";
+const char RECORD_INDEX_MAGIC[] = "SNKIDX1\n";
+const size_t RECORD_MAGIC_SIZE = 8;
+const double CAST_TICK_SECONDS = 0.1;
+
+const int RECORD_WIDTH = FIELD_SIZE_X - 1;
+const int RECORD_HEIGHT = FIELD_SIZE_Y;
+
+static const char KIND_CHARS[4] = { FIELD_CHAR_EMPTY, FIELD_CHAR_WALL, FIELD_CHAR_SNAKE, FIELD_CHAR_APPLE };
+
+static unsigned int kindOf(char ch)
+{
+    switch (ch)
+    {
+    case FIELD_CHAR_WALL: return 1;
+    case FIELD_CHAR_SNAKE: return 2;
+    case FIELD_CHAR_APPLE: return 3;
+    default: return 0;
+    }
+}
+
+static void putVarint(std::vector<unsigned char> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+void GameRecorder::snapshot()
+{
+    cells.assign(RECORD_WIDTH * RECORD_HEIGHT, FIELD_CHAR_EMPTY);
+    for (int y = 0; y < RECORD_HEIGHT; ++y)
+    {
+        for (int x = 0; x < RECORD_WIDTH; ++x)
+            cells[y * RECORD_WIDTH + x] = gameField[y][x];
+    }
+    for (auto &segm : snake)
+        cells[segm.y * RECORD_WIDTH + segm.x] = FIELD_CHAR_SNAKE;
+}
+
+void GameRecorder::apply(const FieldChanges &changes)
+{
+    for (auto &change : changes)
+        cells[change.p.y * RECORD_WIDTH + change.p.x] = change.ch;
+}
+
+/**
+* asciicast v2 writer
+*/
+class CastRecorder : public GameRecorder {
+public:
+    bool begin(const std::string &file) override
+    {
+        out.open(file, std::ios::binary);
+        snapshot();
+
+        out << "{\"version\": 2, \"width\": " << RECORD_WIDTH << ", \"height\": " << RECORD_HEIGHT
+            << ", \"timestamp\": " << static_cast<long long>(std::time(nullptr)) << "}\n";
+
+        std::string frame = "\\u001b[2J";
+        for (int y = 0; y < RECORD_HEIGHT; ++y)
+        {
+            frame += "\\u001b[" + std::to_string(y + 1) + ";1H";
+            frame.append(&cells[y * RECORD_WIDTH], RECORD_WIDTH);
+        }
+        event(0, frame);
+        return static_cast<bool>(out);
+    }
+
+    void tick(unsigned int tick, const FieldChanges &changes) override
+    {
+        std::string frame;
+        for (auto &change : changes)
+        {
+            frame += "\\u001b[" + std::to_string(change.p.y + 1) + ";" + std::to_string(change.p.x + 1) + "H";
+            frame += change.ch;
+        }
+        apply(changes);
+        event(tick, frame);
+    }
+
+    bool finish() override
+    {
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    void event(unsigned int tick, const std::string &data)
+    {
+        out << '[' << tick * CAST_TICK_SECONDS << ", \"o\", \"" << data << "\"]\n";
+    }
+
+    std::ofstream out;
+};
+
+/**
+* Compact delta writer, buffers the whole game and writes it at the end
+*/
+class DeltaRecorder : public GameRecorder {
+public:
+    bool begin(const std::string &file) override
+    {
+        fileName = file;
+        snapshot();
+
+        buffer.clear();
+        buffer.insert(buffer.end(), RECORD_MAGIC, RECORD_MAGIC + RECORD_MAGIC_SIZE);
+        buffer.push_back(static_cast<unsigned char>(RECORD_WIDTH));
+        buffer.push_back(static_cast<unsigned char>(RECORD_HEIGHT));
+        buffer.push_back(static_cast<unsigned char>(RECORD_KEYFRAME_INTERVAL & 0xFF));
+        buffer.push_back(static_cast<unsigned char>(RECORD_KEYFRAME_INTERVAL >> 8));
+
+        keyframes.clear();
+        keyframe(0);
+        return true;
+    }
+
+    void tick(unsigned int tick, const FieldChanges &changes) override
+    {
+        apply(changes);
+
+        putVarint(buffer, static_cast<uint64_t>(changes.size()) << 1);
+        for (auto &change : changes)
+            putVarint(buffer, (static_cast<uint64_t>(change.p.y * RECORD_WIDTH + change.p.x) << 2) | kindOf(change.ch));
+
+        if (tick % RECORD_KEYFRAME_INTERVAL == 0)
+            keyframe(tick);
+    }
+
+    bool finish() override
+    {
+        size_t indexOffset = buffer.size();
+        putVarint(buffer, keyframes.size());
+        for (auto &key : keyframes)
+        {
+            putVarint(buffer, key.first);
+            putVarint(buffer, key.second);
+        }
+        for (int i = 0; i < 4; ++i)
+            buffer.push_back(static_cast<unsigned char>(indexOffset >> (8 * i)));
+        buffer.insert(buffer.end(), RECORD_INDEX_MAGIC, RECORD_INDEX_MAGIC + RECORD_MAGIC_SIZE);
+
+        std::ofstream out(fileName, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        return static_cast<bool>(out);
+    }
+
+private:
+    void keyframe(unsigned int tick)
+    {
+        keyframes.push_back(std::make_pair(tick, buffer.size()));
+        putVarint(buffer, 1);
+        putVarint(buffer, tick);
+
+        for (size_t i = 0; i < cells.size();)
+        {
+            size_t run = 1;
+            while (i + run < cells.size() && cells[i + run] == cells[i])
+                run++;
+            putVarint(buffer, run);
+            buffer.push_back(static_cast<unsigned char>(cells[i]));
+            i += run;
+        }
+    }
+
+    std::string fileName;
+    std::vector<unsigned char> buffer;
+    std::vector<std::pair<unsigned int, size_t>> keyframes;
+};
+
+std::unique_ptr<GameRecorder> createRecorder(const std::string &file)
+{
+    const std::string castExt = ".cast";
+    if (file.size() >= castExt.size() && file.compare(file.size() - castExt.size(), castExt.size(), castExt) == 0)
+        return std::unique_ptr<GameRecorder>(new CastRecorder());
+    return std::unique_ptr<GameRecorder>(new DeltaRecorder());
+}
+
+bool RecordingReader::open(const std::string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    const size_t headerSize = RECORD_MAGIC_SIZE + 4;
+    const size_t trailerSize = 4 + RECORD_MAGIC_SIZE;
+    if (data.size() < headerSize + trailerSize
+        || !std::equal(RECORD_MAGIC, RECORD_MAGIC + RECORD_MAGIC_SIZE, data.begin())
+        || !std::equal(RECORD_INDEX_MAGIC, RECORD_INDEX_MAGIC + RECORD_MAGIC_SIZE, data.end() - RECORD_MAGIC_SIZE))
+        return false;
+
+    fieldWidth = data[RECORD_MAGIC_SIZE];
+    fieldHeight = data[RECORD_MAGIC_SIZE + 1];
+
+    const unsigned char* trailer = &data[data.size() - trailerSize];
+    end = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<size_t>(trailer[3]) << 24);
+    if (end < headerSize || end > data.size() - trailerSize)
+        return false;
+
+    // Index is read with the same varint reader, so borrow pos
+    pos = end;
+    uint64_t count = 0, keyTick = 0, offset = 0;
+    if (!readVarint(count))
+        return false;
+    keyframes.clear();
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!readVarint(keyTick) || !readVarint(offset) || offset >= end)
+            return false;
+        keyframes.push_back(std::make_pair(static_cast<unsigned int>(keyTick), static_cast<size_t>(offset)));
+    }
+
+    cells.assign(fieldWidth * fieldHeight, FIELD_CHAR_EMPTY);
+    return !keyframes.empty() && seek(0);
+}
+
+bool RecordingReader::readVarint(uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; pos < data.size() && shift < 64; shift += 7)
+    {
+        unsigned char byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Reads one record, keyframes are skipped through unless we landed on one
+bool RecordingReader::readRecord()
+{
+    uint64_t value;
+    if (pos >= end || !readVarint(value))
+        return false;
+
+    if (value & 1)
+    {
+        uint64_t keyTick;
+        if (!readVarint(keyTick))
+            return false;
+        for (size_t i = 0; i < cells.size();)
+        {
+            uint64_t run;
+            if (!readVarint(run) || pos >= end || run == 0 || i + run > cells.size())
+                return false;
+            std::fill(cells.begin() + i, cells.begin() + i + static_cast<size_t>(run), static_cast<char>(data[pos++]));
+            i += static_cast<size_t>(run);
+        }
+        tick = static_cast<unsigned int>(keyTick);
+        return true;
+    }
+
+    for (uint64_t i = 0; i < (value >> 1); ++i)
+    {
+        uint64_t change;
+        if (!readVarint(change) || (change >> 2) >= cells.size())
+            return false;
+        cells[static_cast<size_t>(change >> 2)] = KIND_CHARS[change & 3];
+    }
+    tick++;
+    return true;
+}
+
+bool RecordingReader::seek(unsigned int target)
+{
+    size_t key = 0;
+    while (key + 1 < keyframes.size() && keyframes[key + 1].first <= target)
+        key++;
+
+    pos = keyframes[key].second;
+    if (!readRecord())
+        return false;
+
+    while (tick < target)
+    {
+        if (!next())
+            return false;
+    }
+    return true;
+}
+
+bool RecordingReader::next()
+{
+    size_t start = pos;
+    unsigned int startTick = tick;
+    while (readRecord())
+    {
+        // Keyframe repeats the state of the tick just read
+        if (tick != startTick)
+            return true;
+    }
+    pos = start;
+    return false;
+}
+
+int runPlayer(const Args &args)
+{
+    RecordingReader reader;
+    if (!reader.open(args.value("--play", "")))
+    {
+        std::cerr << "Can't read recording: " << args.value("--play", "") << std::endl;
+        return 1;
+    }
+
+    if (!reader.seek(static_cast<unsigned int>(args.intValue("--seek", 0))))
+    {
+        std::cerr << "Recording is shorter than tick " << args.value("--seek", "") << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Renderer> renderer = createRenderer(args.value("--renderer", "curses"));
+    if (!renderer || !renderer->init())
+    {
+        std::cerr << "Can't start renderer: " << args.value("--renderer", "curses") << std::endl;
+        return 1;
+    }
+    renderer->setInputTimeout(static_cast<int>(args.intValue("--play-delay", 100)));
+
+    do
+    {
+        renderer->clearScreen();
+        for (int y = 0; y < reader.height(); ++y)
+        {
+            for (int x = 0; x < reader.width(); ++x)
+                renderer->drawChar(x, y, reader.cell(x, y));
+        }
+        std::string status = "Tick " + std::to_string(reader.currentTick());
+        renderer->drawString(5, reader.height() + 2, status.c_str());
+        renderer->refreshScreen();
+
+        if (renderer->readInput() == 'q')
+            break;
+    } while (reader.next());
+
+    renderer->shutdown();
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "snake.h"
+#include "args.h"
+
+/**
+* Game recording built from the cells changed every tick,
+* so it runs at simulation speed and never touches the screen.
+*
+* "*.cast" files are asciicast v2, playable by asciinema, with one
+* event per tick at a fixed tick length.
+*
+* Any other name gets the compact delta format:
+*   header: "SNKREC1\n", u8 width, u8 height, u16 keyframe interval
+*   records, each starting with a varint v:
+*     v & 1 == 0 - tick with v >> 1 changes, each varint (cell << 2 | kind)
+*     v & 1 == 1 - keyframe: varint tick, then RLE runs of {varint length, u8 char}
+*   index: varint count, {varint tick, varint offset} per keyframe
+*   trailer: u32 index offset, "SNKIDX1\n"
+* Keyframes make seeking cheap: jump to the last one before the tick and
+* replay a few deltas from there.
+*/
+const unsigned int RECORD_KEYFRAME_INTERVAL = 256;
+
+class GameRecorder {
+public:
+    virtual ~GameRecorder() {}
+
+    // Starts from the current game state
+    virtual bool begin(const std::string &file) = 0;
+    virtual void tick(unsigned int tick, const FieldChanges &changes) = 0;
+    virtual bool finish() = 0;
+
+protected:
+    // Field with the snake drawn on it, the way it looks on screen
+    void snapshot();
+    void apply(const FieldChanges &changes);
+
+    std::vector<char> cells;
+};
+
+std::unique_ptr<GameRecorder> createRecorder(const std::string &file);
+
+// Plays a delta recording through the renderer: --play file [--seek tick] [--play-delay ms]
+int runPlayer(const Args &args);
+
+/**
+* Reader of the compact delta format with random access to any tick.
+*/
+class RecordingReader {
+public:
+    bool open(const std::string &file);
+
+    bool seek(unsigned int tick);   // Cells become the state after this tick
+    bool next();                    // Advances by one tick, false at the end
+
+    unsigned int currentTick() const { return tick; }
+    int width() const { return fieldWidth; }
+    int height() const { return fieldHeight; }
+    char cell(int x, int y) const { return cells[y * fieldWidth + x]; }
+
+private:
+    bool readVarint(uint64_t &value);
+    bool readRecord();
+
+    std::vector<unsigned char> data;
+    size_t pos;
+    size_t end;                     // Start of the index
+    int fieldWidth;
+    int fieldHeight;
+    unsigned int tick;
+    std::vector<char> cells;
+    std::vector<std::pair<unsigned int, size_t>> keyframes;
+};
@@ -0,0 +1,79 @@
+#ifdef _WIN32
+#define PDC_DLL_BUILD
+#include "curses.h"
+#else
+#include <ncurses.h>
+#endif
+#include "renderer.h"
+#include "ansirenderer.h"
+
+class CursesRenderer : public Renderer {
+public:
+    bool init() override
+    {
+        initscr();              // Go to curses-mode
+        keypad(stdscr, true);   // Turn on function keys reading
+
+        noecho();
+        cbreak();
+
+        curs_set(0);
+        return true;
+    }
+
+    void shutdown() override
+    {
+        endwin();               // Turn off curses-mode. Mandatory!
+    }
+
+    void clearScreen() override { clear(); }
+    void drawString(int x, int y, const char* str) override { mvaddstr(y, x, str); }
+    void drawChar(int x, int y, char ch) override { mvaddch(y, x, ch); }
+    void refreshScreen() override { refresh(); }
+
+    int readInput() override
+    {
+        switch (int ch = getch())
+        {
+        case ERR: // Returned by curses if there were no user input
+            return INPUT_NONE;
+        case KEY_UP:
+            return INPUT_UP;
+        case KEY_DOWN:
+            return INPUT_DOWN;
+        case KEY_LEFT:
+            return INPUT_LEFT;
+        case KEY_RIGHT:
+            return INPUT_RIGHT;
+        default:
+            return ch;
+        }
+    }
+
+    void setInputTimeout(int ms) override { timeout(ms); }
+};
+
+class NullRenderer : public Renderer {
+public:
+    bool init() override { return true; }
+    void shutdown() override {}
+
+    void clearScreen() override {}
+    void drawString(int, int, const char*) override {}
+    void drawChar(int, int, char) override {}
+    void refreshScreen() override {}
+
+    int readInput() override { return INPUT_NONE; }
+    void setInputTimeout(int) override {}
+};
+
+std::unique_ptr<Renderer> createRenderer(const std::string &name)
+{
+    if (name == "curses")
+        return std::unique_ptr<Renderer>(new CursesRenderer());
+    if (name == "ansi")
+        return std::unique_ptr<Renderer>(new AnsiRenderer());
+    if (name == "null")
+        return std::unique_ptr<Renderer>(new NullRenderer());
+    return std::unique_ptr<Renderer>();
+}
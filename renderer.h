@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+/**
+* Output and keyboard backend of the game.
+* "curses" - the classic ncurses/PDCurses one,
+* "ansi" - writes escape sequences straight to the terminal,
+* "null" - draws nothing, for measuring the simulation alone.
+*/
+const int INPUT_NONE = -1;
+const int INPUT_UP = 0x101;
+const int INPUT_DOWN = 0x102;
+const int INPUT_LEFT = 0x103;
+const int INPUT_RIGHT = 0x104;
+
+class Renderer {
+public:
+    virtual ~Renderer() {}
+
+    virtual bool init() = 0;
+    virtual void shutdown() = 0;
+
+    virtual void clearScreen() = 0;
+    virtual void drawString(int x, int y, const char* str) = 0;
+    virtual void drawChar(int x, int y, char ch) = 0;
+    virtual void refreshScreen() = 0;
+
+    // Key code or INPUT_NONE. Waits up to the input timeout
+    virtual int readInput() = 0;
+    virtual void setInputTimeout(int ms) = 0;   // -1 - wait for a key, 0 - don't wait
+};
+
+std::unique_ptr<Renderer> createRenderer(const std::string &name);
@@ -0,0 +1,212 @@
+#include "apples.h"
+#include "bitboard.h"
+#include "rewind.h"
+
+RewindBuffer::RewindBuffer(unsigned int capacity)
+    : capacity(capacity > REWIND_KEYFRAME_TICKS ? capacity : REWIND_KEYFRAME_TICKS), firstCell(0)
+{
+}
+
+void RewindBuffer::setCapacity(unsigned int ticks)
+{
+    capacity = ticks > REWIND_KEYFRAME_TICKS ? ticks : REWIND_KEYFRAME_TICKS;
+    trim();
+}
+
+void RewindBuffer::reset()
+{
+    keyframes.clear();
+    deltas.clear();
+    firstCell += cells.size();
+    cells.clear();
+    shadow = gameField;
+    takeKeyframe();
+}
+
+void RewindBuffer::takeKeyframe()
+{
+    Keyframe frame;
+    frame.tick = gameTick;
+    frame.field = gameField;
+    frame.snake.assign(snake.begin(), snake.end());
+    frame.applesEaten = applesEaten;
+    frame.random = randomEngine;
+    frame.randomDraws = randomDraws;
+    keyframes.push_back(frame);
+}
+
+void RewindBuffer::record(const SnakeSegment &oldTail, bool grew)
+{
+    if (keyframes.empty() || gameTick != keyframes.front().tick + deltas.size() + 1)
+    {
+        // Missed a tick, nothing to chain onto
+        reset();
+        return;
+    }
+
+    TickDelta d = { snake.front(), oldTail, grew, applesEaten, randomDraws, firstCell + cells.size(), 0 };
+
+    // The snake lives in the snake list, not in gameField
+    for (auto &change : fieldChanges)
+    {
+        if (change.ch == FIELD_CHAR_SNAKE)
+            continue;
+        char &before = shadow[change.p.y][change.p.x];
+        if (before == change.ch)
+            continue;
+        CellDelta c = { change.p, before, change.ch };
+        cells.push_back(c);
+        before = change.ch;
+        d.cellCount++;
+    }
+    deltas.push_back(d);
+
+    if (gameTick - keyframes.back().tick >= REWIND_KEYFRAME_TICKS)
+        takeKeyframe();
+    trim();
+}
+
+void RewindBuffer::trim()
+{
+    while (deltas.size() > capacity && keyframes.size() > 1)
+    {
+        unsigned int dropped = keyframes[1].tick - keyframes[0].tick;
+        keyframes.pop_front();
+
+        uint64_t keep = deltas[dropped].firstCell;
+        deltas.erase(deltas.begin(), deltas.begin() + dropped);
+        cells.erase(cells.begin(), cells.begin() + static_cast<size_t>(keep - firstCell));
+        firstCell = keep;
+    }
+}
+
+unsigned int RewindBuffer::available() const
+{
+    return keyframes.empty() ? 0 : gameTick - keyframes.front().tick;
+}
+
+const RewindBuffer::TickDelta &RewindBuffer::delta(unsigned int tick) const
+{
+    return deltas[tick - keyframes.front().tick - 1];
+}
+
+const RewindBuffer::CellDelta &RewindBuffer::cell(uint64_t position) const
+{
+    return cells[static_cast<size_t>(position - firstCell)];
+}
+
+void RewindBuffer::setCell(const Point &p, char ch)
+{
+    if (gameField[p.y][p.x] == FIELD_CHAR_APPLE)
+        apples.erase(p);
+    if (ch == FIELD_CHAR_APPLE)
+        apples.insert(p);
+
+    gameField[p.y][p.x] = ch;
+    shadow[p.y][p.x] = ch;
+    fieldChanges.push_back(FieldChange(p, ch));
+}
+
+unsigned int RewindBuffer::rewind(unsigned int ticks)
+{
+    if (ticks > available())
+        ticks = available();
+    if (ticks == 0)
+        return 0;
+
+    const unsigned int target = gameTick - ticks;
+    size_t frame = keyframes.size() - 1;
+    while (keyframes[frame].tick > target)
+        frame--;
+    const Keyframe &key = keyframes[frame];
+
+    clearFieldChanges();
+
+    if (ticks <= target - key.tick)
+    {
+        // Undo tick by tick, newest first
+        for (unsigned int t = gameTick; t > target; --t)
+        {
+            const TickDelta &d = delta(t);
+            for (unsigned int i = d.cellCount; i-- > 0; )
+            {
+                const CellDelta &c = cell(d.firstCell + i);
+                setCell(c.p, c.before);
+            }
+
+            snake.pop_front();
+            fieldChanges.push_back(FieldChange(d.head, gameField[d.head.y][d.head.x]));
+            if (!d.grew)
+            {
+                snake.push_back(d.tail);
+                fieldChanges.push_back(FieldChange(d.tail, FIELD_CHAR_SNAKE));
+            }
+        }
+    }
+    else
+    {
+        // Load the keyframe and replay forward from it
+        gameField = key.field;
+        shadow = key.field;
+        snake.assign(key.snake.begin(), key.snake.end());
+
+        apples.reset(FIELD_SIZE_X - 1, FIELD_SIZE_Y);
+        for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+        {
+            for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+            {
+                if (gameField[y][x] == FIELD_CHAR_APPLE)
+                    apples.insert(Point(x, y));
+            }
+        }
+
+        for (unsigned int t = key.tick + 1; t <= target; ++t)
+        {
+            const TickDelta &d = delta(t);
+            for (unsigned int i = 0; i < d.cellCount; ++i)
+            {
+                const CellDelta &c = cell(d.firstCell + i);
+                setCell(c.p, c.after);
+            }
+
+            snake.front().dirX = d.head.dirX;
+            snake.front().dirY = d.head.dirY;
+            snake.push_front(d.head);
+            if (!d.grew)
+                snake.pop_back();
+        }
+
+        // Everything may have changed
+        clearFieldChanges();
+        for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+        {
+            for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+                fieldChanges.push_back(FieldChange(Point(x, y), gameField[y][x]));
+        }
+        for (auto &segm : snake)
+            fieldChanges.push_back(FieldChange(segm, FIELD_CHAR_SNAKE));
+    }
+
+    // The head turns the way it was heading at the target tick
+    const SnakeSegment &head = target == key.tick ? key.snake.front() : delta(target).head;
+    snake.front().dirX = head.dirX;
+    snake.front().dirY = head.dirY;
+
+    applesEaten = target == key.tick ? key.applesEaten : delta(target).applesEaten;
+    unsigned long long draws = target == key.tick ? key.randomDraws : delta(target).randomDraws;
+    randomEngine = key.random;
+    randomEngine.discard(draws - key.randomDraws);
+    randomDraws = draws;
+
+    gameTick = target;
+    exitGame = false;
+    gameSerial++;
+    syncSnakeCells();
+
+    // The future is gone, new ticks continue from here
+    deltas.erase(deltas.begin() + (target - keyframes.front().tick), deltas.end());
+    uint64_t keep = deltas.empty() ? firstCell : deltas.back().firstCell + deltas.back().cellCount;
+    cells.erase(cells.begin() + static_cast<size_t>(keep - firstCell), cells.end());
+    keyframes.erase(keyframes.begin() + frame + 1, keyframes.end());
+    return ticks;
+}
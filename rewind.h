@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+#include "snake.h"
+
+/**
+* Time travel for a running game.
+*
+* Every tick stores only what it changed: the new head, the tail it dropped
+* (unless the snake grew) and the field cells it changed with their old and new
+* values. Every REWIND_KEYFRAME_TICKS ticks a full copy of the state is kept
+* as well, including the random engine, so apples respawn the same way after
+* a rewind.
+*
+* rewind(k) either undoes the last k ticks or replays forward from the closest
+* keyframe, whichever is shorter, so it costs O(min(k, REWIND_KEYFRAME_TICKS)).
+* History is bounded: once it is longer than the capacity, the oldest keyframe
+* and the ticks after it are dropped.
+*
+* Level changes (initLevel, swapLevel, new games) start a new history.
+*/
+const unsigned int REWIND_KEYFRAME_TICKS = 64;
+
+class RewindBuffer {
+public:
+    explicit RewindBuffer(unsigned int capacity = 1024);
+
+    void setCapacity(unsigned int ticks);
+    void reset();       // History starts at the current state
+
+    // After every step, with the tail segment from before the step
+    void record(const SnakeSegment &oldTail, bool grew);
+
+    unsigned int available() const;     // Ticks we can go back
+    unsigned int rewind(unsigned int ticks);    // Returns how far it went back
+
+private:
+    struct CellDelta {
+        Point p;
+        char before;
+        char after;
+    };
+
+    struct TickDelta {
+        SnakeSegment head;
+        SnakeSegment tail;
+        bool grew;
+        unsigned int applesEaten;
+        unsigned long long randomDraws;
+        uint64_t firstCell;             // Position in cells counting from the very first one
+        unsigned int cellCount;
+    };
+
+    struct Keyframe {
+        unsigned int tick;
+        GameFieldArray field;
+        std::vector<SnakeSegment> snake;
+        unsigned int applesEaten;
+        std::mt19937 random;
+        unsigned long long randomDraws;
+    };
+
+    void takeKeyframe();
+    void trim();
+    const TickDelta &delta(unsigned int tick) const;
+    const CellDelta &cell(uint64_t position) const;
+    void setCell(const Point &p, char ch);
+
+    unsigned int capacity;
+    GameFieldArray shadow;              // gameField as of the last record()
+    std::deque<Keyframe> keyframes;
+    std::deque<TickDelta> deltas;       // Tick keyframes.front().tick + 1 onwards
+    std::deque<CellDelta> cells;
+    uint64_t firstCell;                 // Position of cells.front()
+};
+
+extern thread_local RewindBuffer* rewindBuffer;     // Set to record the game for rewinding
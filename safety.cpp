@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <utility>
+#include "safety.h"
+
+const int SAFETY_CELLS = FieldSize::cells();
+const int SAFETY_OFFSETS[4] = { -FieldSize::pitch(), FieldSize::pitch(), -1, 1 };
+
+static int cellOf(const Point &p) { return fieldBit(p); }
+
+// No path compression, so every union can be undone
+int SafetyOracle::find(int cell) const
+{
+    while (parent[cell] != cell)
+        cell = parent[cell];
+    return cell;
+}
+
+void SafetyOracle::join(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b)
+        return;
+    if (size[a] < size[b])
+        std::swap(a, b);
+
+    parent[b] = a;
+    size[a] += size[b];
+    Undo undo = { b, a };
+    history.push_back(undo);
+}
+
+void SafetyOracle::rollback(size_t mark)
+{
+    while (history.size() > mark)
+    {
+        const Undo &undo = history.back();
+        size[undo.root] -= size[undo.child];
+        parent[undo.child] = undo.child;
+        history.pop_back();
+    }
+}
+
+void SafetyOracle::rebuild()
+{
+    // Walls only change with a new game or level
+    if (builtSerial != gameSerial || parent.empty())
+    {
+        walkable.clear();
+        for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+        {
+            for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+            {
+                if (gameField[y][x] != FIELD_CHAR_WALL)
+                    walkable.set(fieldBit(Point(x, y)));
+            }
+        }
+        parent.resize(SAFETY_CELLS);
+        size.resize(SAFETY_CELLS);
+    }
+
+    history.clear();
+
+    // Tail will move away, so it doesn't block
+    free = walkable;
+    free.andNot(snakeCells);
+    tail = cellOf(snake.back());
+    if (walkable.test(tail))
+        free.set(tail);
+
+    // Cells next to the head join per query
+    int head = cellOf(snake.front());
+    candidateCount = 0;
+    for (int offset : SAFETY_OFFSETS)
+    {
+        int cell = head + offset;
+        if (isFree(cell))
+        {
+            candidates[candidateCount++] = cell;
+            free.reset(cell);
+        }
+    }
+
+    // Label every region with a flat tree, so finds in queries are one step
+    left = free;
+    for (int root = left.lowest(); root >= 0; root = left.lowest())
+    {
+        region.clear();
+        region.set(root);
+        size[root] = static_cast<unsigned int>(region.fill(left));
+        region.forEach([this, root](int cell) { parent[cell] = root; });
+        left.andNot(region);
+    }
+
+    for (int i = 0; i < candidateCount; ++i)
+    {
+        int cell = candidates[i];
+        free.set(cell);
+        parent[cell] = cell;
+        size[cell] = 1;
+    }
+
+    builtSerial = gameSerial;
+    builtTick = gameTick;
+}
+
+bool SafetyOracle::isSafe(const Point &to)
+{
+    if (parent.empty() || builtSerial != gameSerial || builtTick != gameTick)
+        rebuild();
+
+    int cell = cellOf(to);
+    return isFree(cell) && cell != tail;
+}
+
+MoveSafety SafetyOracle::check(const Point &to)
+{
+    if (parent.empty() || builtSerial != gameSerial || builtTick != gameTick)
+        rebuild();
+
+    MoveSafety result = { 0, 0 };
+    int target = cellOf(to);
+    if (!isFree(target))
+        return result;
+
+    bool isCandidate = false;
+    for (int i = 0; i < candidateCount; ++i)
+        isCandidate = isCandidate || candidates[i] == target;
+
+    // Other candidates stay free after the move, so they join their neighbours
+    for (int i = 0; i < candidateCount; ++i)
+    {
+        int cell = candidates[i];
+        if (cell == target)
+            continue;
+        for (int offset : SAFETY_OFFSETS)
+        {
+            int next = cell + offset;
+            if (next != target && isFree(next))
+                join(cell, next);
+        }
+    }
+
+    if (!isCandidate)
+    {
+        // Not next to the head: its own region is the answer
+        result.area = size[find(target)];
+        result.regions = 1;
+    }
+    else
+    {
+        int roots[4];
+        int rootCount = 0;
+        result.area = 1;
+        for (int offset : SAFETY_OFFSETS)
+        {
+            int next = target + offset;
+            if (!isFree(next))
+                continue;
+
+            int root = find(next);
+            bool seen = false;
+            for (int i = 0; i < rootCount; ++i)
+                seen = seen || roots[i] == root;
+            if (!seen)
+            {
+                roots[rootCount++] = root;
+                result.area += size[root];
+            }
+        }
+        result.regions = rootCount;
+    }
+
+    rollback(0);
+    return result;
+}
+
+static thread_local SafetyOracle oracle;
+
+MoveSafety checkMoveSafety(const Point &to)
+{
+    return oracle.check(to);
+}
+
+bool isSafeMove(const Point &to)
+{
+    return oracle.isSafe(to);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "bitboard.h"
+#include "snake.h"
+
+/**
+* Answers "how many free cells can the snake reach after moving to X"
+* for all four moves of the current tick.
+*
+* Free cells (not walls, not snake except its tail) are labelled into a
+* flat union-find once per tick, leaving out the four cells next to the head.
+* Regions are found by flood filling bitboards, see bitboard.h.
+* Each move then joins the other three candidates, reads the regions
+* around X and rolls the joins back, so the four answers cost only a
+* handful of unions on top of the one shared pass.
+*/
+struct MoveSafety {
+    unsigned int area;      // Free cells reachable from X, X included. 0 if X is blocked
+    unsigned int regions;   // Separate regions around X, more than one means the move cuts the field
+};
+
+class SafetyOracle {
+public:
+    SafetyOracle() : tail(-1), candidateCount(0), builtSerial(0), builtTick(0) {}
+
+    MoveSafety check(const Point &to);
+    bool isSafe(const Point &to);     // Same answer as isSafeCell() from this tick's grid
+
+private:
+    struct Undo {
+        int child;
+        int root;
+    };
+
+    int find(int cell) const;
+    void join(int a, int b);
+    void rollback(size_t mark);
+
+    void rebuild();
+    bool isFree(int cell) const { return cell >= 0 && cell < FieldSize::cells() && free.test(cell); }
+
+    std::vector<int> parent;                // By bit number, see fieldBit()
+    std::vector<unsigned int> size;
+    FieldBits walkable;                     // Not a wall
+    FieldBits free;                         // Not a wall and not snake, tail excluded
+    FieldBits left;                         // Free cells no region has taken yet
+    FieldBits region;
+    std::vector<Undo> history;
+
+    int tail;
+    int candidates[4];
+    int candidateCount;
+
+    unsigned int builtSerial;
+    unsigned int builtTick;
+};
+
+MoveSafety checkMoveSafety(const Point &to);
+bool isSafeMove(const Point &to);
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "scores.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+const char SCORE_LOG_MAGIC[8] = { 'S', 'N', 'K', 'S', 'C', 'O', 'R', '1' };
+const char SCORE_INDEX_MAGIC[8] = { 'S', 'N', 'K', 'S', 'I', 'D', 'X', '1' };
+const size_t SCORE_LOG_HEADER = 8;
+const size_t SCORE_RECORD_SIZE = 64;
+const size_t SCORE_INDEX_HEADER = 16;
+const size_t SCORE_ENTRY_SIZE = 16;
+const size_t SCORE_NAME_SIZE = 12;
+
+static uint32_t crc32(const unsigned char* data, size_t size)
+{
+    static const std::vector<uint32_t> table = []()
+    {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void putLe(unsigned char* p, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static uint64_t getLe(const unsigned char* p, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+uint64_t scoreLevelHash(const std::string &level)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char ch : level)
+    {
+        hash ^= ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Record layout: crc, score, ticks, seed, flags, reserved, time, level hash, bot, level
+static void encodeRecord(const ScoreRecord &record, unsigned char* p)
+{
+    memset(p, 0, SCORE_RECORD_SIZE);
+    putLe(p + 4, record.score, 4);
+    putLe(p + 8, record.ticks, 4);
+    putLe(p + 12, record.seed, 4);
+    putLe(p + 16, record.flags, 4);
+    putLe(p + 24, record.time, 8);
+    putLe(p + 32, record.levelHash, 8);
+    memcpy(p + 40, record.bot.data(), std::min(record.bot.size(), SCORE_NAME_SIZE));
+    memcpy(p + 52, record.level.data(), std::min(record.level.size(), SCORE_NAME_SIZE));
+    putLe(p, crc32(p + 4, SCORE_RECORD_SIZE - 4), 4);
+}
+
+static bool decodeRecord(const unsigned char* p, ScoreRecord &record)
+{
+    if (getLe(p, 4) != crc32(p + 4, SCORE_RECORD_SIZE - 4))
+        return false;
+
+    record.score = static_cast<uint32_t>(getLe(p + 4, 4));
+    record.ticks = static_cast<uint32_t>(getLe(p + 8, 4));
+    record.seed = static_cast<uint32_t>(getLe(p + 12, 4));
+    record.flags = static_cast<uint32_t>(getLe(p + 16, 4));
+    record.time = getLe(p + 24, 8);
+    record.levelHash = getLe(p + 32, 8);
+
+    const char* bot = reinterpret_cast<const char*>(p + 40);
+    const char* level = reinterpret_cast<const char*>(p + 52);
+    record.bot.assign(bot, std::find(bot, bot + SCORE_NAME_SIZE, '\0'));
+    record.level.assign(level, std::find(level, level + SCORE_NAME_SIZE, '\0'));
+    return true;
+}
+
+#ifdef _WIN32
+static int64_t fileSize(int fd) { return _lseeki64(fd, 0, SEEK_END); }
+static bool readAt(int fd, int64_t offset, unsigned char* data, size_t size)
+{
+    return _lseeki64(fd, offset, SEEK_SET) == offset && _read(fd, data, static_cast<unsigned int>(size)) == static_cast<int>(size);
+}
+static bool truncateTo(int fd, int64_t size) { return _chsize_s(fd, size) == 0; }
+static bool seekStart(int fd) { return _lseeki64(fd, 0, SEEK_SET) == 0; }
+static bool writeAll(int fd, const char* data, size_t size) { return _write(fd, data, static_cast<unsigned int>(size)) == static_cast<int>(size); }
+static bool syncFile(int fd) { return _commit(fd) == 0; }
+static int openLog(const std::string &file) { return _open(file.c_str(), _O_RDWR | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE); }
+static void closeLog(int fd) { _close(fd); }
+static bool lockLog(int fd)
+{
+    OVERLAPPED at = {};
+    return LockFileEx(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &at) != 0;
+}
+static void unlockLog(int fd)
+{
+    OVERLAPPED at = {};
+    UnlockFileEx(reinterpret_cast<HANDLE>(_get_osfhandle(fd)), 0, MAXDWORD, MAXDWORD, &at);
+}
+#else
+static int64_t fileSize(int fd) { return lseek(fd, 0, SEEK_END); }
+static bool readAt(int fd, int64_t offset, unsigned char* data, size_t size)
+{
+    return pread(fd, data, size, offset) == static_cast<ssize_t>(size);
+}
+static bool truncateTo(int fd, int64_t size) { return ftruncate(fd, size) == 0; }
+static bool seekStart(int fd) { return lseek(fd, 0, SEEK_SET) == 0; }
+static bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+static bool syncFile(int fd) { return fsync(fd) == 0; }
+static int openLog(const std::string &file) { return ::open(file.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644); }
+static void closeLog(int fd) { ::close(fd); }
+static bool lockLog(int fd) { return flock(fd, LOCK_EX) == 0; }
+static void unlockLog(int fd) { flock(fd, LOCK_UN); }
+#endif
+
+ScoreLog::ScoreLog() : fd(-1), batchSize(1), batched(0)
+{
+}
+
+ScoreLog::~ScoreLog()
+{
+    close();
+}
+
+bool ScoreLog::open(const std::string &file, unsigned int batch)
+{
+    close();
+    batchSize = batch > 0 ? batch : 1;
+
+    fd = openLog(file);
+    if (fd < 0)
+        return false;
+
+    // Other games may append to the same log, their batches go in whole under the lock
+    if (!lockLog(fd))
+    {
+        close();
+        return false;
+    }
+    bool ok = repairTail();
+    unlockLog(fd);
+    if (!ok)
+        close();
+    return ok;
+}
+
+bool ScoreLog::repairTail()
+{
+    int64_t size = fileSize(fd);
+    unsigned char header[SCORE_LOG_HEADER];
+    if (size < static_cast<int64_t>(SCORE_LOG_HEADER))
+    {
+        // fileSize() left the offset at the old end, the header goes at 0
+        return truncateTo(fd, 0) && seekStart(fd) && writeAll(fd, SCORE_LOG_MAGIC, SCORE_LOG_HEADER) && syncFile(fd);
+    }
+
+    if (!readAt(fd, 0, header, SCORE_LOG_HEADER) || memcmp(header, SCORE_LOG_MAGIC, SCORE_LOG_HEADER) != 0)
+        return false;
+
+    // Drop whatever a crash left half written at the end
+    int64_t records = (size - static_cast<int64_t>(SCORE_LOG_HEADER)) / SCORE_RECORD_SIZE;
+    unsigned char data[SCORE_RECORD_SIZE];
+    ScoreRecord record;
+    while (records > 0 && (!readAt(fd, SCORE_LOG_HEADER + (records - 1) * SCORE_RECORD_SIZE, data, SCORE_RECORD_SIZE)
+                           || !decodeRecord(data, record)))
+    {
+        records--;
+    }
+
+    int64_t valid = SCORE_LOG_HEADER + records * SCORE_RECORD_SIZE;
+    return valid == size || truncateTo(fd, valid);
+}
+
+void ScoreLog::append(const ScoreRecord &record)
+{
+    unsigned char data[SCORE_RECORD_SIZE];
+    encodeRecord(record, data);
+    buffer.append(reinterpret_cast<const char*>(data), SCORE_RECORD_SIZE);
+
+    if (++batched >= batchSize)
+        flush();
+}
+
+bool ScoreLog::flush()
+{
+    if (fd < 0)
+        return false;
+    if (buffer.empty())
+        return true;
+
+    bool ok = lockLog(fd);
+    if (ok)
+    {
+        ok = writeAll(fd, buffer.data(), buffer.size()) && syncFile(fd);
+        unlockLog(fd);
+    }
+    buffer.clear();
+    batched = 0;
+    return ok;
+}
+
+bool ScoreLog::close()
+{
+    if (fd < 0)
+        return true;
+
+    bool ok = flush();
+    closeLog(fd);
+    fd = -1;
+    return ok;
+}
+
+struct IndexEntry {
+    uint64_t levelHash;
+    uint32_t score;
+    uint32_t record;
+};
+
+static IndexEntry readEntry(const unsigned char* table, uint64_t i)
+{
+    const unsigned char* p = table + i * SCORE_ENTRY_SIZE;
+    IndexEntry e;
+    e.levelHash = getLe(p, 8);
+    e.score = static_cast<uint32_t>(getLe(p + 8, 4));
+    e.record = static_cast<uint32_t>(getLe(p + 12, 4));
+    return e;
+}
+
+static std::string indexFile(const std::string &logFile)
+{
+    return logFile + ".idx";
+}
+
+bool ScoreIndex::open(const std::string &logFile)
+{
+    indexed = 0;
+    index.close();
+    if (!log.open(logFile) || log.size() < SCORE_LOG_HEADER || memcmp(log.data(), SCORE_LOG_MAGIC, SCORE_LOG_HEADER) != 0)
+        return false;
+
+    // A missing or damaged index only makes queries slower
+    if (index.open(indexFile(logFile)) && index.size() >= SCORE_INDEX_HEADER
+        && memcmp(index.data(), SCORE_INDEX_MAGIC, 8) == 0)
+    {
+        uint64_t count = getLe(index.data() + 8, 8);
+        if (count <= recordCount() && index.size() == SCORE_INDEX_HEADER + 2 * count * SCORE_ENTRY_SIZE)
+            indexed = count;
+    }
+    return true;
+}
+
+uint64_t ScoreIndex::recordCount() const
+{
+    return (log.size() - SCORE_LOG_HEADER) / SCORE_RECORD_SIZE;
+}
+
+bool ScoreIndex::readRecord(uint64_t i, ScoreRecord &record) const
+{
+    return decodeRecord(log.data() + SCORE_LOG_HEADER + i * SCORE_RECORD_SIZE, record);
+}
+
+std::vector<ScoreRecord> ScoreIndex::best(const unsigned char* table, uint64_t first, uint64_t last,
+                                          bool anyLevel, uint64_t levelHash, size_t count) const
+{
+    std::vector<std::pair<uint64_t, ScoreRecord>> found;
+    ScoreRecord record;
+
+    for (uint64_t i = first; i < last && found.size() < count; ++i)
+    {
+        uint64_t n = readEntry(table, i).record;
+        if (readRecord(n, record))
+            found.push_back(std::make_pair(n, record));
+    }
+
+    // Records appended after the last index update
+    for (uint64_t n = indexed; n < recordCount(); ++n)
+    {
+        if (readRecord(n, record) && (anyLevel || record.levelHash == levelHash))
+            found.push_back(std::make_pair(n, record));
+    }
+
+    std::stable_sort(found.begin(), found.end(), [](const std::pair<uint64_t, ScoreRecord> &a, const std::pair<uint64_t, ScoreRecord> &b)
+    {
+        return a.second.score != b.second.score ? a.second.score > b.second.score : a.first < b.first;
+    });
+
+    std::vector<ScoreRecord> result;
+    for (size_t i = 0; i < found.size() && i < count; ++i)
+        result.push_back(found[i].second);
+    return result;
+}
+
+std::vector<ScoreRecord> ScoreIndex::top(size_t count) const
+{
+    const unsigned char* byScore = indexed ? index.data() + SCORE_INDEX_HEADER : nullptr;
+    return best(byScore, 0, indexed, true, 0, count);
+}
+
+std::vector<ScoreRecord> ScoreIndex::topForLevel(const std::string &level, size_t count) const
+{
+    uint64_t hash = scoreLevelHash(level);
+    if (!indexed)
+        return best(nullptr, 0, 0, false, hash, count);
+
+    const unsigned char* byLevel = index.data() + SCORE_INDEX_HEADER + indexed * SCORE_ENTRY_SIZE;
+
+    // First entry of the level, entries of one level are sorted by score
+    uint64_t lo = 0, hi = indexed;
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (readEntry(byLevel, mid).levelHash < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    uint64_t end = lo;
+    while (end < indexed && end - lo < count && readEntry(byLevel, end).levelHash == hash)
+        end++;
+    return best(byLevel, lo, end, false, hash, count);
+}
+
+static bool byScore(const IndexEntry &a, const IndexEntry &b)
+{
+    return a.score != b.score ? a.score > b.score : a.record < b.record;
+}
+
+static bool byLevel(const IndexEntry &a, const IndexEntry &b)
+{
+    return a.levelHash != b.levelHash ? a.levelHash < b.levelHash : byScore(a, b);
+}
+
+bool updateScoreIndex(const std::string &logFile)
+{
+    MappedFile log;
+    if (!log.open(logFile) || log.size() < SCORE_LOG_HEADER)
+        return false;
+    uint64_t records = (log.size() - SCORE_LOG_HEADER) / SCORE_RECORD_SIZE;
+
+    std::vector<IndexEntry> scoreTable, levelTable;
+    uint64_t indexed = 0;
+    {
+        MappedFile old;
+        if (old.open(indexFile(logFile)) && old.size() >= SCORE_INDEX_HEADER
+            && memcmp(old.data(), SCORE_INDEX_MAGIC, 8) == 0)
+        {
+            uint64_t count = getLe(old.data() + 8, 8);
+            if (count <= records && old.size() == SCORE_INDEX_HEADER + 2 * count * SCORE_ENTRY_SIZE)
+            {
+                indexed = count;
+                scoreTable.resize(count);
+                levelTable.resize(count);
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    scoreTable[i] = readEntry(old.data() + SCORE_INDEX_HEADER, i);
+                    levelTable[i] = readEntry(old.data() + SCORE_INDEX_HEADER, count + i);
+                }
+            }
+        }
+    }
+
+    if (indexed == records)
+        return true;
+    if (records > 0xFFFFFFFFu)
+        return false;
+
+    std::vector<IndexEntry> added;
+    ScoreRecord record;
+    uint64_t covered = indexed;
+    for (; covered < records; ++covered)
+    {
+        if (!decodeRecord(log.data() + SCORE_LOG_HEADER + covered * SCORE_RECORD_SIZE, record))
+            break;      // Torn tail, the next ScoreLog::open() cuts it off
+        IndexEntry e = { record.levelHash, record.score, static_cast<uint32_t>(covered) };
+        added.push_back(e);
+    }
+
+    std::vector<IndexEntry> merged(scoreTable.size() + added.size());
+    std::sort(added.begin(), added.end(), byScore);
+    std::merge(scoreTable.begin(), scoreTable.end(), added.begin(), added.end(), merged.begin(), byScore);
+    scoreTable.swap(merged);
+
+    merged.assign(levelTable.size() + added.size(), IndexEntry());
+    std::sort(added.begin(), added.end(), byLevel);
+    std::merge(levelTable.begin(), levelTable.end(), added.begin(), added.end(), merged.begin(), byLevel);
+    levelTable.swap(merged);
+
+    std::string out(SCORE_INDEX_HEADER + 2 * covered * SCORE_ENTRY_SIZE, '\0');
+    unsigned char* p = reinterpret_cast<unsigned char*>(&out[0]);
+    memcpy(p, SCORE_INDEX_MAGIC, 8);
+    putLe(p + 8, covered, 8);
+    p += SCORE_INDEX_HEADER;
+    for (auto table : { &scoreTable, &levelTable })
+    {
+        for (auto &e : *table)
+        {
+            putLe(p, e.levelHash, 8);
+            putLe(p + 8, e.score, 4);
+            putLe(p + 12, e.record, 4);
+            p += SCORE_ENTRY_SIZE;
+        }
+    }
+
+    // Readers see either the old or the new index, never half of one
+    std::string tmpFile = indexFile(logFile) + ".tmp";
+    {
+        std::ofstream stream(tmpFile, std::ios::binary);
+        stream.write(out.data(), out.size());
+        if (!stream)
+            return false;
+    }
+    std::remove(indexFile(logFile).c_str());    // Windows won't rename over an existing file
+    return std::rename(tmpFile.c_str(), indexFile(logFile).c_str()) == 0;
+}
+
+int runScoreQuery(const Args &args)
+{
+    std::string file = args.value("--scores", "");
+    if (args.has("--reindex") && !updateScoreIndex(file))
+    {
+        std::cerr << "Can't update score index: " << file << std::endl;
+        return 1;
+    }
+    if (!args.has("--top"))
+        return 0;
+
+    ScoreIndex scores;
+    if (!scores.open(file))
+    {
+        std::cerr << "Can't open score log: " << file << std::endl;
+        return 1;
+    }
+
+    size_t count = static_cast<size_t>(args.intValue("--top", 10));
+    std::vector<ScoreRecord> best = args.has("--top-level")
+        ? scores.topForLevel(args.value("--top-level", ""), count)
+        : scores.top(count);
+
+    for (size_t i = 0; i < best.size(); ++i)
+    {
+        const ScoreRecord &r = best[i];
+        char date[32] = "";
+        time_t time = static_cast<time_t>(r.time);
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&time));
+        std::cout << i + 1 << ". " << r.score << " " << r.bot << " on " << r.level << ", seed " << r.seed
+                  << ", " << r.ticks << " ticks" << (r.flags & SCORE_FLAG_CRASHED ? ", crashed" : "")
+                  << ", " << date << std::endl;
+    }
+    std::cout << scores.recordCount() << " games logged" << std::endl;
+    return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "args.h"
+#include "mappedfile.h"
+
+/**
+* Persistent high scores.
+*
+* The log is append-only: an 8 byte header "SNKSCOR1" then 64 byte records,
+* each starting with a CRC-32 of the rest. A record torn by a crash fails its
+* CRC and is cut off the next time the log is opened for writing. Appends are
+* buffered and go out with one write() and fsync() per batch. Several games may
+* log to one file: it is opened for appending, and the tail repair and every
+* batch hold an exclusive lock on it.
+*
+* The index (<log>.idx) is a memory mapped, sorted copy of {level hash, score, record}:
+*   header: "SNKSIDX1", u64 indexed record count
+*   all records by score, best first
+*   all records by level hash, then by score
+* Top-N is a prefix of the first table, a level is found by binary search in the second.
+* updateScoreIndex() only reads the records appended since the last update
+* and merges them in, but it still rewrites the whole index. Tournaments
+* update it after their batch, single games leave it to --reindex. Queries
+* also look at the unindexed tail, so they are correct even with a stale index.
+*/
+struct ScoreRecord {
+    uint32_t score;
+    uint32_t ticks;
+    uint32_t seed;
+    uint32_t flags;         // SCORE_FLAG_*
+    uint64_t time;          // Unix time
+    std::string bot;        // Both names are truncated to 12 chars on disk,
+    std::string level;      // levelHash is taken from the full level name
+    uint64_t levelHash;
+};
+
+const uint32_t SCORE_FLAG_CRASHED = 1;
+
+uint64_t scoreLevelHash(const std::string &level);
+
+class ScoreLog {
+public:
+    ScoreLog();
+    ~ScoreLog();
+
+    bool open(const std::string &file, unsigned int batchSize = 256);
+    void append(const ScoreRecord &record);
+    bool flush();           // Writes and fsyncs the current batch
+    bool close();
+
+private:
+    ScoreLog(const ScoreLog&) = delete;
+    ScoreLog& operator=(const ScoreLog&) = delete;
+
+    bool repairTail();      // Under the lock
+
+    int fd;
+    unsigned int batchSize;
+    unsigned int batched;
+    std::string buffer;
+};
+
+class ScoreIndex {
+public:
+    bool open(const std::string &logFile);
+
+    // Best scores overall or on one level, best first
+    std::vector<ScoreRecord> top(size_t count) const;
+    std::vector<ScoreRecord> topForLevel(const std::string &level, size_t count) const;
+
+    uint64_t recordCount() const;
+
+private:
+    bool readRecord(uint64_t i, ScoreRecord &record) const;
+    std::vector<ScoreRecord> best(const unsigned char* table, uint64_t first, uint64_t last,
+                                  bool anyLevel, uint64_t levelHash, size_t count) const;
+
+    MappedFile log;
+    MappedFile index;
+    uint64_t indexed;
+};
+
+// Merges records appended since the last update into <log>.idx
+bool updateScoreIndex(const std::string &logFile);
+
+// "--top N [--top-level name] --scores file", "--reindex --scores file"
+int runScoreQuery(const Args &args);
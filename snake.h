@@ -1,5 +1,20 @@
 #pragma once
 
+#include <array>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+const int FIELD_SIZE_X = 27;   // Includes the trailing '\0' column
+const int FIELD_SIZE_Y = 16;
+const int SNAKE_INIT_SIZE = 6;
+
+const char FIELD_CHAR_WALL = '#';
+const char FIELD_CHAR_APPLE = '@';
+const char FIELD_CHAR_SNAKE = '*';
+const char FIELD_CHAR_EMPTY = ' ';
+
 enum class DirectionY {
 	UP = -1,
 	NONE = 0,
@@ -32,3 +47,48 @@ public:
 	bool operator== (const Point &point) const { return x == point.x && y == point.y; }
 	bool operator== (const SnakeSegment &segm) const { return x == segm.x && y == segm.y; }
 };
+
+// Single cell change made by the game logic during one tick
+struct FieldChange {
+	Point p;
+	char ch;
+
+	FieldChange(const Point &_p, char _ch) : p(_p), ch(_ch) {}
+};
+
+typedef std::array<std::array<char, FIELD_SIZE_X>, FIELD_SIZE_Y> GameFieldArray;
+typedef std::list<SnakeSegment> Snake;
+typedef std::vector<FieldChange> FieldChanges;
+
+// Game state is per thread, so headless games can run in parallel
+extern thread_local GameFieldArray gameField;
+extern thread_local Snake snake;
+extern thread_local bool exitGame;
+extern thread_local FieldChanges fieldChanges;  // Cells changed since the last clearFieldChanges()
+extern thread_local unsigned int gameTick;
+extern thread_local unsigned int applesEaten;
+extern thread_local unsigned int gameSerial;    // Changes whenever a new game or level starts, or time is rewound
+extern thread_local std::mt19937 randomEngine;
+extern thread_local unsigned long long randomDraws; // random() calls since seedRandom()
+
+char getFieldChar(const Point &p);
+bool isWall(const Point &p);
+bool isApple(const Point &p);
+bool checkCollisionWithSnake(const Point &p);
+
+bool moveSnake();
+bool checkCrash();
+void setSnakeDirection(DirectionX dirX, DirectionY dirY);
+
+void clearFieldChanges();
+
+void seedRandom(unsigned int seed);
+unsigned int random(unsigned int min, unsigned int max);
+
+// Headless game logic, no curses calls
+void initGame(unsigned int seed);
+void initLevel(const GameFieldArray &level);
+bool swapLevel(const GameFieldArray &level);    // Mid-game, keeps the snake, false if a wall would hit it
+bool readLevel(const std::string &levelFile, GameFieldArray &level);
+bool isLevelClosed(const GameFieldArray &level);     // Walls all around, so the snake can't leave the field
+bool stepGame();    // Returns false when the snake has crashed
@@ -0,0 +1,170 @@
+#include "spawn.h"
+
+const uint32_t ALIAS_SCALE = 1u << 31;
+
+void AliasTable::build(const std::vector<uint32_t> &weights)
+{
+    threshold.assign(weights.size(), 0);
+    alias.assign(weights.size(), 0);
+
+    uint64_t total = 0;
+    for (auto w : weights)
+        total += w;
+    if (total == 0)
+    {
+        alias.clear();
+        return;
+    }
+
+    // Vose: scaled weights average ALIAS_SCALE, columns below it get topped up from one above it
+    const uint64_t n = weights.size();
+    std::vector<uint64_t> scaled(weights.size());
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+        scaled[i] = static_cast<uint64_t>(static_cast<double>(weights[i]) * n / total * ALIAS_SCALE);
+        (scaled[i] < ALIAS_SCALE ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t s = small.back(), l = large.back();
+        small.pop_back();
+        threshold[s] = static_cast<uint32_t>(scaled[s]);
+        alias[s] = l;
+
+        scaled[l] -= ALIAS_SCALE - scaled[s];
+        if (scaled[l] < ALIAS_SCALE)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Leftovers are full columns, rounding only ever leaves them a hair off
+    large.insert(large.end(), small.begin(), small.end());
+    for (auto i : large)
+    {
+        threshold[i] = ALIAS_SCALE;
+        alias[i] = i;
+    }
+}
+
+size_t AliasTable::pick() const
+{
+    size_t column = random(0, static_cast<unsigned int>(alias.size()));
+    return random(0, ALIAS_SCALE) < threshold[column] ? column : alias[column];
+}
+
+void WeightTree::build(const std::vector<uint32_t> &weights)
+{
+    tree.assign(weights.size() + 1, 0);
+    sum = 0;
+    for (size_t i = 1; i < tree.size(); ++i)
+    {
+        tree[i] += weights[i - 1];
+        sum += weights[i - 1];
+        size_t parent = i + (i & (0 - i));
+        if (parent < tree.size())
+            tree[parent] += tree[i];
+    }
+
+    topStep = 1;
+    while (topStep * 2 < tree.size())
+        topStep *= 2;
+}
+
+void WeightTree::add(size_t i, int64_t delta)
+{
+    // Unsigned wraparound takes care of negative deltas
+    sum += static_cast<uint64_t>(delta);
+    for (++i; i < tree.size(); i += i & (0 - i))
+        tree[i] += static_cast<uint64_t>(delta);
+}
+
+size_t WeightTree::find(uint64_t target) const
+{
+    size_t pos = 0;
+    for (size_t step = topStep; step > 0; step >>= 1)
+    {
+        if (pos + step < tree.size() && tree[pos + step] <= target)
+        {
+            pos += step;
+            target -= tree[pos];
+        }
+    }
+    return pos;
+}
+
+AppleSpawner::AppleSpawner() : weighted(false), freeBuilt(false), freeSerial(0), freeSeen(0)
+{
+}
+
+void AppleSpawner::indexCells()
+{
+    cellIndex.assign(FIELD_SIZE_X * FIELD_SIZE_Y, -1);
+    for (size_t i = 0; i < cells.size(); ++i)
+        cellIndex[cells[i].y * FIELD_SIZE_X + cells[i].x] = static_cast<int>(i);
+    freeBuilt = false;
+}
+
+void AppleSpawner::useDefault()
+{
+    weighted = false;
+    cells.clear();
+    weights.clear();
+    for (unsigned int y = FIELD_SIZE_Y / 2; y < FIELD_SIZE_Y - 2; ++y)
+    {
+        for (unsigned int x = 2; x < FIELD_SIZE_X - 2; ++x)
+        {
+            cells.push_back(Point(x, y));
+            weights.push_back(1);
+        }
+    }
+    indexCells();
+}
+
+void AppleSpawner::loadLevel(GameFieldArray &level)
+{
+    std::vector<Point> spawnCells;
+    std::vector<uint32_t> spawnWeights;
+    bool hasDigits = false;
+
+    for (unsigned int y = 0; y < FIELD_SIZE_Y; ++y)
+    {
+        for (unsigned int x = 0; x < FIELD_SIZE_X - 1; ++x)
+        {
+            int weight = spawnWeight(level[y][x]);
+            if (weight < 0)
+                continue;
+
+            hasDigits = true;
+            level[y][x] = FIELD_CHAR_EMPTY;
+            if (weight > 0)
+            {
+                spawnCells.push_back(Point(x, y));
+                spawnWeights.push_back(static_cast<uint32_t>(weight));
+            }
+        }
+    }
+
+    if (!hasDigits || spawnCells.empty())
+    {
+        useDefault();
+        return;
+    }
+
+    weighted = true;
+    cells.swap(spawnCells);
+    weights.swap(spawnWeights);
+    table.build(weights);
+    indexCells();
+}
+
+Point AppleSpawner::pick() const
+{
+    // Same draws as ever for levels without weights, so old seeds replay the same games
+    if (!weighted)
+        return Point(random(2, FIELD_SIZE_X - 2), random(FIELD_SIZE_Y / 2, FIELD_SIZE_Y - 2));
+    return cells[table.pick()];
+}
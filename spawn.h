@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "snake.h"
+
+/**
+* Where apples appear.
+*
+* Digits in a level file are empty cells with a spawn weight, '0' means never.
+* A level without digits keeps the old rule: uniform over the lower half of the board.
+*
+* Weighted picks use a Walker alias table, O(1) per pick however many cells
+* there are. The table is built once per level: occupied cells are rejected
+* by the caller and picked again, which stays O(1) on average as long as the
+* snake doesn't cover most of the spawn weight.
+*
+* When it does, pickFree() draws from a Fenwick tree over the weights of the
+* free cells. The tree is built once per level and then follows fieldChanges,
+* so a pick and every changed cell cost O(log n), not a walk over the field.
+*/
+class AliasTable {
+public:
+    void build(const std::vector<uint32_t> &weights);
+    size_t pick() const;
+    bool empty() const { return alias.empty(); }
+
+private:
+    std::vector<uint32_t> threshold;    // Out of ALIAS_SCALE, keep the column below it
+    std::vector<uint32_t> alias;
+};
+
+// Running totals over weights that change one at a time
+class WeightTree {
+public:
+    void build(const std::vector<uint32_t> &weights);
+    void add(size_t i, int64_t delta);
+    uint64_t total() const { return sum; }
+    size_t find(uint64_t target) const;     // First index whose running total is above target
+
+private:
+    std::vector<uint64_t> tree;     // 1 based, tree[i] sums the (i & -i) weights up to i
+    size_t topStep;
+    uint64_t sum;
+};
+
+inline int spawnWeight(char ch) { return ch >= '0' && ch <= '9' ? ch - '0' : -1; }
+
+class AppleSpawner {
+public:
+    AppleSpawner();
+
+    void useDefault();
+    void loadLevel(GameFieldArray &level);  // Takes the digits out of the level
+
+    Point pick() const;
+
+    // Weighted pick among the cells accepted by isFree, for a crowded board
+    template <typename Pred>
+    bool pickFree(Pred isFree, Point &p);
+
+    // Call with the same isFree before fieldChanges is cleared, then changesCleared()
+    template <typename Pred>
+    void syncFree(Pred isFree);
+    void changesCleared() { freeSeen = 0; }
+
+private:
+    void indexCells();
+
+    bool weighted;
+    std::vector<Point> cells;
+    std::vector<uint32_t> weights;
+    AliasTable table;
+
+    std::vector<int> cellIndex;         // Field cell -> index into cells or -1
+    std::vector<uint8_t> freeCell;      // What isFree said when the cell last changed
+    WeightTree freeWeights;
+    bool freeBuilt;
+    unsigned int freeSerial;            // gameSerial it was built for
+    size_t freeSeen;                    // fieldChanges already applied
+};
+
+extern thread_local AppleSpawner appleSpawner;
+
+template <typename Pred>
+void AppleSpawner::syncFree(Pred isFree)
+{
+    if (!freeBuilt || freeSerial != gameSerial)
+        return;
+
+    for (size_t i = freeSeen; i < fieldChanges.size(); ++i)
+    {
+        const Point &p = fieldChanges[i].p;
+        int index = cellIndex[p.y * FIELD_SIZE_X + p.x];
+        if (index < 0)
+            continue;
+
+        uint8_t free = isFree(p) ? 1 : 0;
+        if (free != freeCell[index])
+        {
+            freeCell[index] = free;
+            freeWeights.add(index, free ? static_cast<int64_t>(weights[index]) : -static_cast<int64_t>(weights[index]));
+        }
+    }
+    freeSeen = fieldChanges.size();
+}
+
+template <typename Pred>
+bool AppleSpawner::pickFree(Pred isFree, Point &p)
+{
+    if (freeBuilt && freeSerial == gameSerial)
+    {
+        syncFree(isFree);
+    }
+    else
+    {
+        // New game, level or rewind, look at every cell once
+        std::vector<uint32_t> free(cells.size(), 0);
+        freeCell.assign(cells.size(), 0);
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (isFree(cells[i]))
+            {
+                freeCell[i] = 1;
+                free[i] = weights[i];
+            }
+        }
+        freeWeights.build(free);
+        freeBuilt = true;
+        freeSerial = gameSerial;
+        freeSeen = fieldChanges.size();
+    }
+
+    if (freeWeights.total() == 0)
+        return false;
+
+    uint64_t target = random(0, static_cast<unsigned int>(freeWeights.total()));
+    p = cells[freeWeights.find(target)];
+    return true;
+}
@@ -0,0 +1,107 @@
+#include <cerrno>
+#include <thread>
+#include "ticker.h"
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+TickScheduler::TickScheduler(double hz, unsigned int maxCatchUp)
+    : period(hz > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz)) : Clock::duration::zero()),
+      maxCatchUp(maxCatchUp > 0 ? maxCatchUp : 1),
+      totalTicks(0), droppedTicks(0), catchUpTicks(0), jitterSumUs(0), jitterMaxUs(0)
+{
+    histogram.fill(0);
+}
+
+void TickScheduler::start()
+{
+    next = Clock::now() + period;
+}
+
+unsigned int TickScheduler::wait()
+{
+    if (isUnlimited())
+    {
+        totalTicks++;
+        return 1;
+    }
+
+    sleepUntil(next);
+    Clock::time_point now = Clock::now();
+    recordJitter(now - next);
+
+    // One tick for the deadline we slept to, plus every whole period we're past it
+    unsigned long long due = 1 + static_cast<unsigned long long>((now - next) / period);
+    unsigned int steps = static_cast<unsigned int>(due < maxCatchUp ? due : maxCatchUp);
+
+    if (due > steps)
+    {
+        droppedTicks += due - steps;
+        next = now + period;
+    }
+    else
+    {
+        next += period * steps;
+    }
+
+    totalTicks += steps;
+    catchUpTicks += steps - 1;
+    return steps;
+}
+
+void TickScheduler::sleepUntil(Clock::time_point deadline)
+{
+#ifdef __linux__
+    // libstdc++ steady_clock is CLOCK_MONOTONIC, so the time points can be used directly
+    std::chrono::nanoseconds since = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(since.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(since.count() % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        ;
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+void TickScheduler::recordJitter(Clock::duration late)
+{
+    double us = std::chrono::duration<double, std::micro>(late).count();
+    if (us < 0)
+        us = 0;
+
+    jitterSumUs += us;
+    if (us > jitterMaxUs)
+        jitterMaxUs = us;
+
+    int bucket = 0;
+    for (unsigned long long limit = 1; bucket < JITTER_BUCKETS - 1 && us >= limit; limit <<= 1)
+        bucket++;
+    histogram[bucket]++;
+}
+
+void TickScheduler::printStats(std::ostream &out) const
+{
+    unsigned long long wakeups = 0;
+    for (auto count : histogram)
+        wakeups += count;
+
+    out << "Ticks: " << totalTicks << ", caught up: " << catchUpTicks << ", dropped: " << droppedTicks << std::endl;
+    if (wakeups == 0)
+        return;
+
+    out << "Wake up lateness: mean " << jitterSumUs / wakeups << " us, max " << jitterMaxUs << " us" << std::endl;
+    for (int i = 0; i < JITTER_BUCKETS; ++i)
+    {
+        if (histogram[i] == 0)
+            continue;
+        if (i == 0)
+            out << "  < 1 us";
+        else if (i == JITTER_BUCKETS - 1)
+            out << "  >= " << (1ull << (i - 1)) << " us";
+        else
+            out << "  " << (1ull << (i - 1)) << "-" << (1ull << i) << " us";
+        out << ": " << histogram[i] << std::endl;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <ostream>
+
+/**
+* Fixed rate game clock with absolute deadlines, so sleep overshoot
+* doesn't add up over a long game.
+*
+* When a frame takes longer than a tick, wait() returns more than one step
+* and the caller catches up by stepping the simulation several times,
+* at most maxCatchUp. Anything beyond that is dropped and the clock resyncs.
+*
+* Lateness of every wake up goes into a log2 histogram of microseconds.
+*/
+class TickScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int JITTER_BUCKETS = 24;   // Last one also takes everything above 2^22 us
+
+    explicit TickScheduler(double hz = 0, unsigned int maxCatchUp = 5);
+
+    void start();
+    unsigned int wait();        // Sleeps until the next deadline, returns how many ticks are due
+
+    bool isUnlimited() const { return period.count() == 0; }
+
+    unsigned long long ticks() const { return totalTicks; }
+    unsigned long long dropped() const { return droppedTicks; }
+    unsigned long long caughtUp() const { return catchUpTicks; }
+    const std::array<unsigned long long, JITTER_BUCKETS> &jitterHistogram() const { return histogram; }
+
+    void printStats(std::ostream &out) const;
+
+private:
+    void sleepUntil(Clock::time_point deadline);
+    void recordJitter(Clock::duration late);
+
+    Clock::duration period;
+    unsigned int maxCatchUp;
+    Clock::time_point next;
+
+    unsigned long long totalTicks;
+    unsigned long long droppedTicks;
+    unsigned long long catchUpTicks;
+    double jitterSumUs;
+    double jitterMaxUs;
+    std::array<unsigned long long, JITTER_BUCKETS> histogram;
+};
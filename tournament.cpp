@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "apples.h"
+#include "metrics.h"
+#include "scores.h"
+#include "trace.h"
+#include "tournament.h"
+
+typedef std::chrono::steady_clock Clock;
+
+std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (getline(stream, item, ','))
+    {
+        if (!item.empty())
+            items.push_back(item);
+    }
+    return items;
+}
+
+unsigned int threadCount(const Args &args)
+{
+    long threads = args.intValue("--threads", 0);
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    return threads > 0 ? static_cast<unsigned int>(threads) : 1;
+}
+
+struct Level {
+    std::string name;
+    bool isDefault;
+    GameFieldArray field;
+};
+
+MatchResult playMatch(const BotInfo &bot, unsigned int seed, unsigned int maxTicks, GameRecorder* recorder)
+{
+    std::vector<double> decisions;
+    decisions.reserve(std::min(maxTicks, 4096u));     // Most games end long before --max-ticks
+
+    bool crashed = false;
+    while (gameTick < maxTicks)
+    {
+        Clock::time_point start = Clock::now();
+        {
+            TRACE_SCOPE(bot.name);
+            bot.decide();
+        }
+        decisions.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+        bool alive;
+        {
+            TRACE_SCOPE("step");
+            alive = stepGame();
+        }
+        if (metricsEnabled())
+            observeTiming(Timing::TICK, Clock::now() - start);
+        if (recorder)
+            recorder->tick(gameTick, fieldChanges);
+
+        if (!alive)
+        {
+            crashed = true;
+            break;
+        }
+    }
+
+    countMetric(Metric::GAMES);
+
+    MatchResult result;
+    result.bot = bot.name;
+    result.seed = seed;
+    result.score = applesEaten;
+    result.ticks = gameTick;
+    result.crashed = crashed;
+    result.decisionMeanNs = result.decisionP99Ns = result.decisionMaxNs = 0;
+
+    if (!decisions.empty())
+    {
+        double sum = 0;
+        for (double d : decisions)
+            sum += d;
+        result.decisionMeanNs = sum / decisions.size();
+
+        size_t p99 = decisions.size() * 99 / 100;
+        std::nth_element(decisions.begin(), decisions.begin() + p99, decisions.end());
+        result.decisionP99Ns = decisions[p99];
+        result.decisionMaxNs = *std::max_element(decisions.begin(), decisions.end());
+    }
+
+    return result;
+}
+
+static std::string jsonEscape(const std::string &str)
+{
+    std::string out;
+    for (char ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+            out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+static std::string csvField(const std::string &str)
+{
+    // Level names are paths, which may hold commas or quotes
+    if (str.find_first_of(",\"\r\n") == std::string::npos)
+        return str;
+
+    std::string out = "\"";
+    for (char ch : str)
+    {
+        if (ch == '"')
+            out += '"';
+        out += ch;
+    }
+    return out + "\"";
+}
+
+static bool writeCsv(const std::string &file, const std::vector<MatchResult> &results)
+{
+    std::ofstream out(file);
+    out << "bot,level,seed,score,ticks,crashed,decision_ns_mean,decision_ns_p99,decision_ns_max\n";
+    for (auto &r : results)
+    {
+        out << csvField(r.bot) << ',' << csvField(r.level) << ',' << r.seed << ',' << r.score << ',' << r.ticks << ','
+            << (r.crashed ? 1 : 0) << ',' << r.decisionMeanNs << ',' << r.decisionP99Ns << ',' << r.decisionMaxNs << '\n';
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+static bool writeJson(const std::string &file, const std::vector<MatchResult> &results)
+{
+    std::ofstream out(file);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto &r = results[i];
+        out << "  {\"bot\": \"" << jsonEscape(r.bot) << "\", \"level\": \"" << jsonEscape(r.level)
+            << "\", \"seed\": " << r.seed << ", \"score\": " << r.score << ", \"ticks\": " << r.ticks
+            << ", \"crashed\": " << (r.crashed ? "true" : "false")
+            << ", \"decision_ns_mean\": " << r.decisionMeanNs << ", \"decision_ns_p99\": " << r.decisionP99Ns
+            << ", \"decision_ns_max\": " << r.decisionMaxNs << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+static bool logScores(const std::string &file, const std::vector<MatchResult> &results, unsigned int batch)
+{
+    ScoreLog log;
+    if (!log.open(file, batch))
+        return false;
+
+    uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+    for (auto &r : results)
+    {
+        ScoreRecord record;
+        record.score = r.score;
+        record.ticks = r.ticks;
+        record.seed = r.seed;
+        record.flags = r.crashed ? SCORE_FLAG_CRASHED : 0;
+        record.time = now;
+        record.bot = r.bot;
+        record.level = r.level;
+        record.levelHash = scoreLevelHash(r.level);
+        log.append(record);
+    }
+    return log.close() && updateScoreIndex(file);
+}
+
+int runTournament(const Args &args)
+{
+    std::vector<const BotInfo*> bots;
+    for (auto &name : splitList(args.value("--bots", "straight,random,greedy")))
+    {
+        const BotInfo* bot = findBot(name);
+        if (!bot)
+        {
+            std::cerr << "Unknown bot: " << name << std::endl;
+            return 1;
+        }
+        bots.push_back(bot);
+    }
+
+    // Levels are parsed once, every match starts from a copy
+    std::vector<Level> levels;
+    for (auto &name : splitList(args.value("--levels", "default")))
+    {
+        Level level;
+        level.name = name;
+        level.isDefault = name == "default";
+        if (!level.isDefault && !readLevel(name, level.field))
+        {
+            std::cerr << "Can't load level: " << name << std::endl;
+            return 1;
+        }
+        levels.push_back(level);
+    }
+
+    if (args.intValue("--seeds", 10) < 1)
+    {
+        std::cerr << "Bad seed count: " << args.value("--seeds", "") << std::endl;
+        return 1;
+    }
+    unsigned int seedCount = static_cast<unsigned int>(args.intValue("--seeds", 10));
+    unsigned int maxTicks = static_cast<unsigned int>(args.intValue("--max-ticks", 10000));
+    unsigned int threads = threadCount(args);
+    std::string recordDir = args.value("--record-dir", "");
+    unsigned int appleCount = static_cast<unsigned int>(args.intValue("--apples", 1));
+
+    size_t matchCount = bots.size() * levels.size() * seedCount;
+    std::vector<MatchResult> results(matchCount);
+    std::atomic<size_t> nextMatch(0);
+
+    Clock::time_point start = Clock::now();
+
+    auto worker = [&]()
+    {
+        for (size_t i = nextMatch++; i < matchCount; i = nextMatch++)
+        {
+            const BotInfo &bot = *bots[i / (levels.size() * seedCount)];
+            const Level &level = levels[i / seedCount % levels.size()];
+            unsigned int seed = static_cast<unsigned int>(i % seedCount) + 1;
+
+            appleTarget = appleCount;
+            initGame(seed);
+            if (!level.isDefault)
+                initLevel(level.field);
+
+            std::unique_ptr<GameRecorder> recorder;
+            std::string recordFile;
+            if (!recordDir.empty())
+            {
+                recordFile = recordDir + "/" + bot.name + "_" + std::to_string(i / seedCount % levels.size())
+                           + "_" + std::to_string(seed) + ".sdr";
+                recorder = createRecorder(recordFile);
+                recorder->begin(recordFile);
+            }
+
+            results[i] = playMatch(bot, seed, maxTicks, recorder.get());
+            results[i].level = level.name;
+
+            if (recorder && !recorder->finish())
+                std::cerr << "Can't write recording: " << recordFile << std::endl;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; ++i)
+        pool.push_back(std::thread(worker));
+    for (auto &thread : pool)
+        thread.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    unsigned long long totalTicks = 0;
+    for (auto &r : results)
+        totalTicks += r.ticks;
+
+    std::cout << matchCount << " matches on " << threads << " threads in " << seconds << " s, "
+              << static_cast<unsigned long long>(totalTicks / (seconds > 0 ? seconds : 1)) << " ticks/s" << std::endl;
+
+    for (auto bot : bots)
+    {
+        unsigned long long score = 0, ticks = 0;
+        double decision = 0;
+        unsigned int games = 0;
+        for (auto &r : results)
+        {
+            if (r.bot != bot->name)
+                continue;
+            score += r.score;
+            ticks += r.ticks;
+            decision += r.decisionMeanNs;
+            games++;
+        }
+        if (games == 0)
+            continue;
+        std::cout << bot->name << ": avg score " << static_cast<double>(score) / games
+                  << ", avg length " << static_cast<double>(ticks) / games
+                  << ", avg decision " << decision / games << " ns" << std::endl;
+    }
+
+    // Every output is attempted, any that fails fails the run
+    int status = 0;
+    if (args.has("--scores") && !logScores(args.value("--scores", ""), results,
+                                            static_cast<unsigned int>(args.intValue("--scores-batch", 256))))
+    {
+        std::cerr << "Can't write score log: " << args.value("--scores", "") << std::endl;
+        status = 1;
+    }
+    if (args.has("--csv") && !writeCsv(args.value("--csv", ""), results))
+    {
+        std::cerr << "Can't write CSV: " << args.value("--csv", "") << std::endl;
+        status = 1;
+    }
+    if (args.has("--json") && !writeJson(args.value("--json", ""), results))
+    {
+        std::cerr << "Can't write JSON: " << args.value("--json", "") << std::endl;
+        status = 1;
+    }
+
+    return status;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "args.h"
+#include "bots.h"
+#include "recorder.h"
+
+/**
+* Headless tournament: every bot plays every level with every seed.
+* Matches run in parallel, results go to CSV and/or JSON.
+*
+*   --tournament --bots greedy,random --levels a.txt,b.txt --seeds 100
+*   [--threads N] [--max-ticks N] [--csv file] [--json file] [--record-dir dir]
+*   [--scores file [--scores-batch N]] [--apples N]
+*/
+struct MatchResult {
+    std::string bot;
+    std::string level;
+    unsigned int seed;
+    unsigned int score;
+    unsigned int ticks;
+    bool crashed;
+    double decisionMeanNs;
+    double decisionP99Ns;
+    double decisionMaxNs;
+};
+
+// Plays one headless game, gameField must already hold the level
+MatchResult playMatch(const BotInfo &bot, unsigned int seed, unsigned int maxTicks, GameRecorder* recorder = nullptr);
+
+std::vector<std::string> splitList(const std::string &list);
+unsigned int threadCount(const Args &args);
+
+int runTournament(const Args &args);
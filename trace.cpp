@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "trace.h"
+
+const int TRACE_POLL_MS = 100;
+
+/**
+* Only the owning thread writes a ring. It fills the slot first and then
+* publishes it by moving head, a reader copies the slots and then drops
+* those that head has lapped in the meantime.
+*/
+struct TraceRing {
+    std::unique_ptr<TraceEvent[]> events;
+    size_t mask;
+    std::atomic<uint64_t> head;
+    unsigned int tid;
+    bool isMain;
+};
+
+std::atomic<bool> tracingOn(false);
+
+static std::mutex ringsMutex;
+static std::vector<std::unique_ptr<TraceRing>> rings;
+static thread_local TraceRing* threadRing = nullptr;
+static size_t ringCapacity = 0;
+static uint64_t traceStartNs = 0;
+static std::thread::id mainThread;
+static std::atomic<bool> saveRequested(false);
+
+Tracer tracer;
+
+static TraceRing &localRing()
+{
+    if (!threadRing)
+    {
+        std::unique_ptr<TraceRing> ring(new TraceRing());
+        ring->events.reset(new TraceEvent[ringCapacity]);
+        ring->mask = ringCapacity - 1;
+        ring->head = 0;
+        ring->isMain = std::this_thread::get_id() == mainThread;
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ring->tid = static_cast<unsigned int>(rings.size()) + 1;
+        rings.push_back(std::move(ring));
+        threadRing = rings.back().get();
+    }
+    return *threadRing;
+}
+
+void traceEvent(const char* name, uint64_t startNs, uint64_t durationNs)
+{
+    TraceRing &ring = localRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    TraceEvent &event = ring.events[head & ring.mask];
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+#ifdef SIGUSR1
+extern "C" void requestTraceSave(int)
+{
+    saveRequested.store(true, std::memory_order_relaxed);
+}
+#endif
+
+Tracer::Tracer() : running(false)
+{
+}
+
+Tracer::~Tracer()
+{
+    stop();
+}
+
+bool Tracer::start(const std::string &traceFile, size_t capacity)
+{
+    stop();
+
+    file = traceFile;
+    ringCapacity = 2;
+    while (ringCapacity < capacity)
+        ringCapacity <<= 1;
+    traceStartNs = traceClockNs();
+    mainThread = std::this_thread::get_id();
+
+    // Find out now whether the file can be written, not when the trace is needed
+    if (!save())
+        return false;
+
+    tracingOn.store(true, std::memory_order_relaxed);
+    running = true;
+
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, requestTraceSave);
+    thread = std::thread(&Tracer::signalLoop, this);
+#endif
+    return true;
+}
+
+void Tracer::stop()
+{
+    if (!running)
+        return;
+
+    running = false;
+    tracingOn.store(false, std::memory_order_relaxed);
+#ifdef SIGUSR1
+    thread.join();
+    std::signal(SIGUSR1, SIG_DFL);
+#endif
+
+    if (!save())
+        std::cerr << "Can't write trace: " << file << std::endl;
+}
+
+bool Tracer::save()
+{
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream out(tmpFile);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"snake\"}}";
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        std::vector<TraceEvent> events;
+        for (auto &ring : rings)
+        {
+            std::string threadName = ring->isMain ? "main" : "worker " + std::to_string(ring->tid);
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+                << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > ring->mask + 1 ? head - (ring->mask + 1) : 0;
+            events.clear();
+            for (uint64_t i = first; i < head; ++i)
+                events.push_back(ring->events[i & ring->mask]);
+
+            // The owner kept going while we copied, whatever it reached again is garbage
+            uint64_t lapped = ring->head.load(std::memory_order_acquire);
+            uint64_t valid = lapped > ring->mask ? lapped - ring->mask : 0;
+
+            char line[256];
+            for (uint64_t i = std::max(first, valid); i < head; ++i)
+            {
+                const TraceEvent &event = events[i - first];
+                std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"snake\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                              event.name, ring->tid, (static_cast<double>(event.startNs) - traceStartNs) / 1000.0,
+                              event.durationNs / 1000.0);
+                out << line;
+            }
+        }
+
+        out << "\n]}\n";
+        if (!out)
+            return false;
+    }
+#ifdef _WIN32
+    std::remove(file.c_str());      // Windows won't rename over an existing file
+#endif
+    return std::rename(tmpFile.c_str(), file.c_str()) == 0;
+}
+
+void Tracer::signalLoop()
+{
+    while (running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_POLL_MS));
+        if (saveRequested.exchange(false) && !save())
+            std::cerr << "Can't write trace: " << file << std::endl;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+* Timeline of what the game loop and the bots spent their time on, saved in
+* the Chrome trace event format for about:tracing or Perfetto.
+*
+* Every thread appends complete events to its own ring buffer, that is two
+* clock reads and a few stores per event. When the ring is full the oldest
+* events are overwritten, so a long run keeps its last moments, which is
+* where the long frame somebody wants to look at usually is.
+*
+* The trace is saved when the program exits and, where there is SIGUSR1,
+* whenever the process gets that signal.
+*/
+struct TraceEvent {
+    const char* name;           // Must outlive the trace, string literals and bot names do
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+extern std::atomic<bool> tracingOn;
+
+inline bool tracingEnabled() { return tracingOn.load(std::memory_order_relaxed); }
+
+inline uint64_t traceClockNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void traceEvent(const char* name, uint64_t startNs, uint64_t durationNs);
+
+/**
+* Records the scope it lives in as one event.
+*/
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(tracingEnabled() ? name : nullptr)
+    {
+        if (this->name)
+            start = traceClockNs();
+    }
+    ~TraceScope()
+    {
+        if (name)
+            traceEvent(name, start, traceClockNs() - start);
+    }
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+class Tracer {
+public:
+    Tracer();
+    ~Tracer();
+
+    // Events per thread, older ones are overwritten
+    bool start(const std::string &file, size_t capacity);
+    void stop();            // Saves the trace
+
+    bool save();
+
+private:
+    void signalLoop();
+
+    std::string file;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+extern Tracer tracer;
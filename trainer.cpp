@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "trainer.h"
+#include "bots.h"
+#include "tournament.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Individual {
+    BotWeights weights;
+    double fitness;
+};
+
+typedef std::vector<Individual> Population;
+
+const int ELITE_COUNT = 2;
+const int SELECTION_SIZE = 3;
+const double MUTATION_SIGMA = 0.1;
+
+static bool saveCheckpoint(const std::string &file, unsigned int generation, unsigned int seed, const Population &population)
+{
+    // Write aside and rename, so a crash never leaves half a checkpoint
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream out(tmpFile);
+        out.precision(17);
+        out << "snake-population 1\n" << generation << ' ' << seed << ' ' << population.size() << '\n';
+        for (auto &ind : population)
+        {
+            for (auto w : ind.weights)
+                out << w << ' ';
+            out << '\n';
+        }
+        if (!out)
+            return false;
+    }
+    std::remove(file.c_str());
+    return std::rename(tmpFile.c_str(), file.c_str()) == 0;
+}
+
+static bool loadCheckpoint(const std::string &file, unsigned int &generation, unsigned int &seed, Population &population)
+{
+    std::ifstream in(file);
+    std::string magic;
+    int version = 0;
+    size_t size = 0;
+    if (!(in >> magic >> version >> generation >> seed >> size) || magic != "snake-population" || version != 1)
+        return false;
+    if (size < 2)       // Same minimum as --population, selection needs two parents
+        return false;
+
+    population.assign(size, Individual());
+    for (auto &ind : population)
+    {
+        ind.fitness = 0;
+        for (auto &w : ind.weights)
+        {
+            if (!(in >> w))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void evaluate(Population &population, const GameFieldArray* level, unsigned int firstSeed,
+                     unsigned int games, unsigned int maxTicks, unsigned int threads)
+{
+    const BotInfo* bot = findBot("weighted");
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < population.size(); i = next++)
+        {
+            botWeights = population[i].weights;
+
+            double fitness = 0;
+            for (unsigned int g = 0; g < games; ++g)
+            {
+                initGame(firstSeed + g);
+                if (level)
+                    initLevel(*level);
+
+                MatchResult result = playMatch(*bot, firstSeed + g, maxTicks);
+                fitness += result.score + static_cast<double>(result.ticks) / maxTicks;
+            }
+            population[i].fitness = fitness / games;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 0; i < threads; ++i)
+        pool.push_back(std::thread(worker));
+    for (auto &thread : pool)
+        thread.join();
+}
+
+static const Individual& select(const Population &population, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<size_t> pick(0, population.size() - 1);
+    const Individual* best = &population[pick(rng)];
+    for (int i = 1; i < SELECTION_SIZE; ++i)
+    {
+        const Individual &candidate = population[pick(rng)];
+        if (candidate.fitness > best->fitness)
+            best = &candidate;
+    }
+    return *best;
+}
+
+static Population breed(Population &population, std::mt19937 &rng)
+{
+    std::sort(population.begin(), population.end(),
+              [](const Individual &a, const Individual &b) { return a.fitness > b.fitness; });
+
+    Population children(population.begin(), population.begin() + std::min<size_t>(ELITE_COUNT, population.size()));
+
+    std::normal_distribution<double> mutation(0.0, MUTATION_SIGMA);
+    std::bernoulli_distribution coin(0.5);
+    while (children.size() < population.size())
+    {
+        const Individual &mother = select(population, rng);
+        const Individual &father = select(population, rng);
+
+        Individual child;
+        child.fitness = 0;
+        for (int i = 0; i < BOT_WEIGHT_COUNT; ++i)
+            child.weights[i] = (coin(rng) ? mother : father).weights[i] + mutation(rng);
+        children.push_back(child);
+    }
+    return children;
+}
+
+int runTrainer(const Args &args)
+{
+    unsigned int populationSize = static_cast<unsigned int>(std::max(2L, args.intValue("--population", 64)));
+    unsigned int generations = static_cast<unsigned int>(args.intValue("--generations", 50));
+    unsigned int games = static_cast<unsigned int>(std::max(1L, args.intValue("--games", 8)));
+    unsigned int seed = static_cast<unsigned int>(args.intValue("--seed", 1));
+    unsigned int maxTicks = static_cast<unsigned int>(args.intValue("--max-ticks", 2000));
+    unsigned int threads = threadCount(args);
+    std::string checkpoint = args.value("--checkpoint", "");
+
+    GameFieldArray levelField;
+    const GameFieldArray* level = nullptr;
+    if (args.has("--level"))
+    {
+        if (!readLevel(args.value("--level", ""), levelField))
+        {
+            std::cerr << "Can't load level: " << args.value("--level", "") << std::endl;
+            return 1;
+        }
+        level = &levelField;
+    }
+
+    Population population;
+    unsigned int generation = 0;
+
+    if (args.has("--resume"))
+    {
+        if (!loadCheckpoint(checkpoint, generation, seed, population))
+        {
+            std::cerr << "Can't resume from checkpoint: " << checkpoint << std::endl;
+            return 1;
+        }
+        std::cout << "Resumed generation " << generation << " with " << population.size() << " individuals" << std::endl;
+    }
+    else
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<double> spread(0.0, 0.5);
+        for (unsigned int i = 0; i < populationSize; ++i)
+        {
+            Individual ind;
+            ind.fitness = 0;
+            for (int w = 0; w < BOT_WEIGHT_COUNT; ++w)
+                ind.weights[w] = defaultBotWeights[w] + (i == 0 ? 0.0 : spread(rng));
+            population.push_back(ind);
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    unsigned int firstGeneration = generation;
+    Individual best = population.front();
+
+    for (; generation < generations; ++generation)
+    {
+        // Same games for the whole generation, different games every generation
+        evaluate(population, level, seed + generation * games, games, maxTicks, threads);
+
+        auto top = std::max_element(population.begin(), population.end(),
+                                    [](const Individual &a, const Individual &b) { return a.fitness < b.fitness; });
+        best = *top;
+
+        double mean = 0;
+        for (auto &ind : population)
+            mean += ind.fitness;
+        mean /= population.size();
+
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "Generation " << generation << ": best " << best.fitness << ", mean " << mean
+                  << ", " << (generation + 1 - firstGeneration) / seconds << " generations/s" << std::endl;
+
+        // Breeding RNG depends only on seed and generation, so resume is deterministic
+        std::mt19937 rng(seed ^ (generation * 2654435761u));
+        population = breed(population, rng);
+
+        if (!checkpoint.empty() && !saveCheckpoint(checkpoint, generation + 1, seed, population))
+            std::cerr << "Can't write checkpoint: " << checkpoint << std::endl;
+    }
+
+    std::cout << "Best weights:";
+    for (auto w : best.weights)
+        std::cout << ' ' << w;
+    std::cout << std::endl;
+
+    if (args.has("--out") && !saveBotWeights(args.value("--out", ""), best.weights))
+    {
+        std::cerr << "Can't write weights: " << args.value("--out", "") << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
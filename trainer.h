@@ -0,0 +1,14 @@
+#pragma once
+
+#include "args.h"
+
+/**
+* Evolutionary trainer for the "weighted" bot.
+* Every generation all individuals play the same seeded games in parallel,
+* the fittest are bred into the next generation.
+*
+*   --train [--population N] [--generations N] [--games N] [--seed N]
+*   [--threads N] [--max-ticks N] [--level file]
+*   [--checkpoint file] [--resume] [--out weights.txt]
+*/
+int runTrainer(const Args &args);